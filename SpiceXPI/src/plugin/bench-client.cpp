@@ -0,0 +1,100 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ *   Version: MPL 1.1/GPL 2.0/LGPL 2.1
+ *
+ *   The contents of this file are subject to the Mozilla Public License Version
+ *   1.1 (the "License"); you may not use this file except in compliance with
+ *   the License. You may obtain a copy of the License at
+ *   http://www.mozilla.org/MPL/
+ *
+ *   Software distributed under the License is distributed on an "AS IS" basis,
+ *   WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+ *   for the specific language governing rights and limitations under the
+ *   License.
+ *
+ *   Copyright 2026, Red Hat Inc.
+ *
+ *   Alternatively, the contents of this file may be used under the terms of
+ *   either the GNU General Public License Version 2 or later (the "GPL"), or
+ *   the GNU Lesser General Public License Version 2.1 or later (the "LGPL"),
+ *   in which case the provisions of the GPL or the LGPL are applicable instead
+ *   of those above. If you wish to allow use of your version of this file only
+ *   under the terms of either the GPL or the LGPL, and not to allow others to
+ *   use your version of this file under the terms of the MPL, indicate your
+ *   decision by deleting the provisions above and replace them with the notice
+ *   and other provisions required by the GPL or the LGPL. If you do not delete
+ *   the provisions above, a recipient may use your version of this file under
+ *   the terms of any one of the MPL, the GPL or the LGPL.
+ *
+ * ***** END LICENSE BLOCK ***** */
+
+// Stub SPICE client for bench-instances: listens on the controller socket
+// given by SPICE_XPI_SOCKET, reads whatever the plugin sends and exits once
+// the plugin closes the socket or terminates it. It never connects to a
+// server, so only the plugin's own cost per console is measured. With
+// SPICE_XPI_BENCH_BUSY set, it keeps a cpu busy meanwhile, like a client
+// decoding video.
+
+#include "config.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+int main(int argc, char *argv[])
+{
+    const char *name = getenv("SPICE_XPI_SOCKET");
+    struct sockaddr_un local;
+    char buffer[4096];
+    int listen_socket;
+    int controller_socket;
+
+    if (name == NULL || strlen(name) + 1 > sizeof(local.sun_path)) {
+        fprintf(stderr, "bench-client: SPICE_XPI_SOCKET is not set or too long\n");
+        return 1;
+    }
+
+    listen_socket = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_socket == -1) {
+        perror("bench-client: socket");
+        return 1;
+    }
+
+    memset(&local, 0, sizeof(local));
+    local.sun_family = AF_UNIX;
+    strcpy(local.sun_path, name);
+    if (bind(listen_socket, (struct sockaddr *) &local, sizeof(local)) == -1 ||
+        listen(listen_socket, 1) == -1) {
+        perror("bench-client: bind");
+        return 1;
+    }
+
+    controller_socket = accept(listen_socket, NULL, NULL);
+    close(listen_socket);
+    if (controller_socket == -1) {
+        perror("bench-client: accept");
+        return 1;
+    }
+
+    const bool busy = getenv("SPICE_XPI_BENCH_BUSY") != NULL;
+    if (busy)
+        fcntl(controller_socket, F_SETFL, O_NONBLOCK);
+
+    // the handshake and any later property updates are discarded
+    for (;;) {
+        ssize_t len = read(controller_socket, buffer, sizeof(buffer));
+        if (len == 0)
+            break;
+        if (len == -1 && errno != EINTR && !(busy && errno == EAGAIN)) {
+            perror("bench-client: read");
+            break;
+        }
+    }
+
+    close(controller_socket);
+    return 0;
+}
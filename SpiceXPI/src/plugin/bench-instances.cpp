@@ -0,0 +1,510 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ *   Version: MPL 1.1/GPL 2.0/LGPL 2.1
+ *
+ *   The contents of this file are subject to the Mozilla Public License Version
+ *   1.1 (the "License"); you may not use this file except in compliance with
+ *   the License. You may obtain a copy of the License at
+ *   http://www.mozilla.org/MPL/
+ *
+ *   Software distributed under the License is distributed on an "AS IS" basis,
+ *   WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+ *   for the specific language governing rights and limitations under the
+ *   License.
+ *
+ *   Copyright 2026, Red Hat Inc.
+ *
+ *   Alternatively, the contents of this file may be used under the terms of
+ *   either the GNU General Public License Version 2 or later (the "GPL"), or
+ *   the GNU Lesser General Public License Version 2.1 or later (the "LGPL"),
+ *   in which case the provisions of the GPL or the LGPL are applicable instead
+ *   of those above. If you wish to allow use of your version of this file only
+ *   under the terms of either the GPL or the LGPL, and not to allow others to
+ *   use your version of this file under the terms of the MPL, indicate your
+ *   decision by deleting the provisions above and replace them with the notice
+ *   and other provisions required by the GPL or the LGPL. If you do not delete
+ *   the provisions above, a recipient may use your version of this file under
+ *   the terms of any one of the MPL, the GPL or the LGPL.
+ *
+ * ***** END LICENSE BLOCK ***** */
+
+// Loads the plugin into a stub browser host, creates N instances, connects
+// all of them to the stub client (bench-client) and reports, for every N,
+// the creation and connect wall times and what each instance costs the
+// browser process: RSS, threads, open fds and temporary socket
+// directories. Fails, if an instance, which has not connected yet, holds
+// a thread, an fd or a directory, if an instance does not connect, if a
+// cost per connected instance exceeds its limit, or
+// if a thread, an fd or a directory is left over once the instances have
+// been destroyed and the plugin has been shut down:
+//   bench-instances --instances=50,100,500 --max-threads=1.5
+//
+// With --latency, the stub clients keep the cpus busy and every round runs
+// twice, with the browser's scheduling policy and with the client policy
+// of SPICE_XPI_CLIENT_* (nice 19 and SCHED_BATCH, if none is set). Each
+// run reports how late a 1 ms sleep of the browser's main thread wakes up;
+// the numbers depend on the machine, so they are not checked:
+//   bench-instances --instances=4,8,16 --latency=5
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <set>
+#include <vector>
+#include <glib.h>
+
+#include "npplat.h"
+#include "plugin.h"
+
+#define DEFAULT_INSTANCES "10,50,100"
+// an instance costs 25-55 kB, the client thread, 5 fds (the controller
+// socket, the client's output pipes, the wakeup fd of the client thread's
+// context and the child watch) and the socket directory; one more thread,
+// fd or directory fails
+#define DEFAULT_MAX_RSS 256 // kB per instance
+#define DEFAULT_MAX_THREADS 1.5 // per instance
+#define DEFAULT_MAX_FDS 5.5 // per instance
+#define DEFAULT_MAX_TMP_DIRS 1.5 // per instance
+// threads, fds and directories per instance before connect()
+#define MAX_UNCONNECTED 0.5
+#define CONNECT_TIMEOUT 60000 // ms, for all the instances of a round
+#define RELEASE_TIMEOUT 1000 // ms, for the threads to finish after shutdown
+#define LATENCY_INTERVAL 1000 // us, the sleep of the main thread
+#define PLUGIN_MIME_TYPE "application/x-spice"
+
+struct AsyncCall
+{
+    NPP instance;
+    void (*func)(void *);
+    void *data;
+};
+
+struct Usage
+{
+    long rss; // kB
+    long threads;
+    long fds;
+    long tmp_dirs;
+};
+
+struct Latency
+{
+    double median; // ms
+    double p99;
+    double max;
+};
+
+struct Limits
+{
+    double rss;
+    double threads;
+    double fds;
+    double tmp_dirs;
+};
+
+static GAsyncQueue *s_async_calls = NULL;
+
+static const char *s_policy_vars[] = {
+    "SPICE_XPI_CLIENT_CPU_AFFINITY",
+    "SPICE_XPI_CLIENT_NICE",
+    "SPICE_XPI_CLIENT_IOPRIO",
+    "SPICE_XPI_CLIENT_SCHED_BATCH",
+};
+
+// the calls posted for an instance, which has been destroyed in the
+// meantime, are dropped, like the browser does
+static std::set<NPP> s_instances;
+
+// the stub browser host, only the functions reached by the plugin on the
+// connect and shutdown paths do something
+static NPError browser_get_value(NPP instance, NPNVariable variable, void *value)
+{
+    // there is no window, so OnDisconnected is not called
+    return NPERR_GENERIC_ERROR;
+}
+
+static NPError browser_set_value(NPP instance, NPPVariable variable, void *value)
+{
+    return NPERR_NO_ERROR;
+}
+
+static void *browser_mem_alloc(uint32_t size)
+{
+    return g_malloc(size);
+}
+
+static void browser_mem_free(void *ptr)
+{
+    g_free(ptr);
+}
+
+// may be called from any thread, the calls run on the main thread in
+// run_async_calls()
+static void browser_plugin_thread_async_call(NPP instance, void (*func)(void *), void *data)
+{
+    AsyncCall *call = new AsyncCall;
+
+    call->instance = instance;
+    call->func = func;
+    call->data = data;
+    g_async_queue_push(s_async_calls, call);
+}
+
+static void init_browser_funcs(NPNetscapeFuncs *funcs)
+{
+    memset(funcs, 0, sizeof(*funcs));
+    funcs->size = sizeof(*funcs);
+    funcs->version = (NP_VERSION_MAJOR << 8) | NP_VERSION_MINOR;
+    funcs->getvalue = browser_get_value;
+    funcs->setvalue = browser_set_value;
+    funcs->memalloc = browser_mem_alloc;
+    funcs->memfree = browser_mem_free;
+    funcs->pluginthreadasynccall = browser_plugin_thread_async_call;
+}
+
+// waits up to timeout ms for the first call, then runs all the queued ones
+static void run_async_calls(guint timeout)
+{
+    gpointer data = g_async_queue_timeout_pop(s_async_calls, timeout * G_GUINT64_CONSTANT(1000));
+
+    while (data != NULL) {
+        AsyncCall *call = static_cast<AsyncCall *>(data);
+        if (s_instances.count(call->instance) > 0)
+            call->func(call->data);
+        delete call;
+        data = g_async_queue_try_pop(s_async_calls);
+    }
+
+    while (g_main_context_iteration(NULL, FALSE))
+        ;
+}
+
+static long status_field(const gchar *status, const char *field)
+{
+    const char *line = strstr(status, field);
+
+    return line != NULL ? strtol(line + strlen(field), NULL, 10) : -1;
+}
+
+static long count_entries(const char *path, const char *prefix)
+{
+    GDir *dir = g_dir_open(path, 0, NULL);
+    const gchar *name;
+    long count = 0;
+
+    if (dir == NULL)
+        return -1;
+    while ((name = g_dir_read_name(dir)) != NULL) {
+        if (g_str_has_prefix(name, prefix))
+            ++count;
+    }
+    g_dir_close(dir);
+
+    return count;
+}
+
+static Usage get_usage()
+{
+    Usage usage = { -1, -1, -1, -1 };
+    gchar *status = NULL;
+
+    if (g_file_get_contents("/proc/self/status", &status, NULL, NULL)) {
+        usage.rss = status_field(status, "\nVmRSS:");
+        usage.threads = status_field(status, "\nThreads:");
+        g_free(status);
+    }
+    usage.fds = count_entries("/proc/self/fd", "");
+    // created by SpiceControllerUnix for the client socket
+    usage.tmp_dirs = count_entries("/tmp", "spicec-");
+
+    return usage;
+}
+
+static bool released(const Usage &usage, const Usage &before)
+{
+    return usage.threads <= before.threads && usage.fds <= before.fds &&
+           usage.tmp_dirs <= before.tmp_dirs;
+}
+
+// the client threads still finish, once the plugin has let them go
+static Usage wait_for_release(const Usage &before)
+{
+    const gint64 deadline = g_get_monotonic_time() + RELEASE_TIMEOUT * G_GINT64_CONSTANT(1000);
+    Usage usage = get_usage();
+
+    while (!released(usage, before) && g_get_monotonic_time() < deadline) {
+        g_usleep(10000);
+        usage = get_usage();
+    }
+
+    return usage;
+}
+
+static double percentile(const std::vector<gint64> &sorted, double p)
+{
+    return sorted[static_cast<size_t>(p * (sorted.size() - 1))] / 1000.0;
+}
+
+// runs on the main thread, like the timers of the browser, while the
+// clients keep the cpus busy
+static Latency measure_latency(guint seconds)
+{
+    const gint64 end = g_get_monotonic_time() + seconds * G_USEC_PER_SEC;
+    std::vector<gint64> lateness;
+
+    while (g_get_monotonic_time() < end) {
+        const gint64 start = g_get_monotonic_time();
+        g_usleep(LATENCY_INTERVAL);
+        lateness.push_back(g_get_monotonic_time() - start - LATENCY_INTERVAL);
+    }
+    std::sort(lateness.begin(), lateness.end());
+
+    Latency latency = { percentile(lateness, 0.5), percentile(lateness, 0.99),
+                        percentile(lateness, 1.0) };
+    return latency;
+}
+
+static bool check_limit(const char *name, double value, double limit)
+{
+    if (value <= limit)
+        return true;
+
+    g_printerr("%s per instance: %.2f, the limit is %.2f\n", name, value, limit);
+    return false;
+}
+
+// connects count instances at once, returns false if the round failed;
+// the latency is measured, if a policy is given
+static bool run_round(unsigned int count, const Limits *limits,
+                      const char *policy, guint latency)
+{
+    NPNetscapeFuncs browser_funcs;
+    NPPluginFuncs plugin_funcs;
+    std::vector<NPP_t> instances(count);
+    unsigned int connected = 0;
+    bool ok = true;
+
+    init_browser_funcs(&browser_funcs);
+    memset(&plugin_funcs, 0, sizeof(plugin_funcs));
+    plugin_funcs.size = sizeof(plugin_funcs);
+    if (NP_Initialize(&browser_funcs, &plugin_funcs) != NPERR_NO_ERROR) {
+        g_printerr("NP_Initialize failed\n");
+        return false;
+    }
+
+    const Usage before = get_usage();
+    gint64 start = g_get_monotonic_time();
+    for (unsigned int i = 0; i < count; ++i) {
+        NPP instance = &instances[i];
+        memset(instance, 0, sizeof(*instance));
+        if (plugin_funcs.newp(const_cast<char *>(PLUGIN_MIME_TYPE), instance, NP_EMBED,
+                              0, NULL, NULL, NULL) != NPERR_NO_ERROR) {
+            g_printerr("NPP_New failed\n");
+            return false;
+        }
+        s_instances.insert(instance);
+
+        nsPluginInstance *plugin = static_cast<nsPluginInstance *>(instance->pdata);
+        plugin->SetHostIP("127.0.0.1");
+        plugin->SetPort("5900");
+        plugin->SetSecurePort("5901");
+        plugin->SetConnectTimeout(CONNECT_TIMEOUT);
+    }
+    const double create_time = (g_get_monotonic_time() - start) / 1000.0;
+    const Usage created = get_usage();
+
+    start = g_get_monotonic_time();
+    for (unsigned int i = 0; i < count; ++i)
+        static_cast<nsPluginInstance *>(instances[i].pdata)->Connect();
+
+    // the launches are throttled by SPICE_XPI_MAX_PARALLEL_LAUNCHES, all
+    // of them get the whole timeout
+    const gint64 deadline = start + CONNECT_TIMEOUT * G_GINT64_CONSTANT(1000);
+    unsigned int pending = count;
+    while (pending > 0 && g_get_monotonic_time() < deadline) {
+        run_async_calls(10);
+        pending = 0;
+        connected = 0;
+        for (unsigned int i = 0; i < count; ++i) {
+            int32_t status;
+            static_cast<nsPluginInstance *>(instances[i].pdata)->ConnectedStatus(&status);
+            if (status == -2)
+                ++pending;
+            else if (status == -1)
+                ++connected;
+        }
+    }
+    const double connect_time = (g_get_monotonic_time() - start) / 1000.0;
+    const Usage used = get_usage();
+    Latency lateness = { 0, 0, 0 };
+    if (policy != NULL && connected == count)
+        lateness = measure_latency(latency);
+
+    for (unsigned int i = 0; i < count; ++i) {
+        s_instances.erase(&instances[i]);
+        plugin_funcs.destroy(&instances[i], NULL);
+    }
+    // waits for the clients to exit and their threads to finish
+    NP_Shutdown();
+    run_async_calls(0);
+    const Usage after = wait_for_release(before);
+
+    if (limits == NULL)
+        return connected == count;
+
+    printf("%5u instances: created in %8.1f ms; per instance: %6.1f kB RSS, "
+           "%.2f threads, %.2f fds, %.2f tmp dirs\n",
+           count, create_time,
+           double(created.rss - before.rss) / count,
+           double(created.threads - before.threads) / count,
+           double(created.fds - before.fds) / count,
+           double(created.tmp_dirs - before.tmp_dirs) / count);
+    printf("%5u instances: connected in %8.1f ms; per instance: %6.1f kB RSS, "
+           "%.2f threads, %.2f fds, %.2f tmp dirs\n",
+           count, connect_time,
+           double(used.rss - before.rss) / count,
+           double(used.threads - before.threads) / count,
+           double(used.fds - before.fds) / count,
+           double(used.tmp_dirs - before.tmp_dirs) / count);
+    if (policy != NULL)
+        printf("       %s policy, busy clients: the main thread wakes up late by "
+               "%.3f ms (median), %.3f ms (99%%), %.3f ms (max)\n",
+               policy, lateness.median, lateness.p99, lateness.max);
+    fflush(stdout);
+
+    // the controller and its socket directory are created on connect()
+    ok = check_limit("threads before connect()",
+                     double(created.threads - before.threads) / count, MAX_UNCONNECTED) && ok;
+    ok = check_limit("fds before connect()",
+                     double(created.fds - before.fds) / count, MAX_UNCONNECTED) && ok;
+    ok = check_limit("tmp dirs before connect()",
+                     double(created.tmp_dirs - before.tmp_dirs) / count, MAX_UNCONNECTED) && ok;
+
+    if (connected != count) {
+        g_printerr("%u of %u instances did not connect\n", count - connected, count);
+        ok = false;
+    }
+    ok = check_limit("RSS (kB)", double(used.rss - before.rss) / count, limits->rss) && ok;
+    ok = check_limit("threads", double(used.threads - before.threads) / count, limits->threads) && ok;
+    ok = check_limit("fds", double(used.fds - before.fds) / count, limits->fds) && ok;
+    ok = check_limit("tmp dirs", double(used.tmp_dirs - before.tmp_dirs) / count,
+                     limits->tmp_dirs) && ok;
+
+    if (!released(after, before)) {
+        g_printerr("left over after shutdown: %ld threads, %ld fds, %ld tmp dirs\n",
+                   after.threads - before.threads, after.fds - before.fds,
+                   after.tmp_dirs - before.tmp_dirs);
+        ok = false;
+    }
+
+    return ok;
+}
+
+int main(int argc, char *argv[])
+{
+    gchar *instances = NULL;
+    gchar *client = NULL;
+    gint latency = 0;
+    gchar *policy[G_N_ELEMENTS(s_policy_vars)];
+    bool default_policy = true;
+    Limits limits = { DEFAULT_MAX_RSS, DEFAULT_MAX_THREADS, DEFAULT_MAX_FDS, DEFAULT_MAX_TMP_DIRS };
+    GOptionEntry entries[] = {
+        { "instances", 'n', 0, G_OPTION_ARG_STRING, &instances,
+          "Comma separated numbers of instances, default " DEFAULT_INSTANCES, "N,..." },
+        { "client", 0, 0, G_OPTION_ARG_FILENAME, &client,
+          "Stub client, default bench-client next to this program", "PATH" },
+        { "max-rss", 0, 0, G_OPTION_ARG_DOUBLE, &limits.rss,
+          "RSS per instance in kB", "KB" },
+        { "max-threads", 0, 0, G_OPTION_ARG_DOUBLE, &limits.threads,
+          "Threads per instance", "N" },
+        { "max-fds", 0, 0, G_OPTION_ARG_DOUBLE, &limits.fds,
+          "Open fds per instance", "N" },
+        { "max-tmp-dirs", 0, 0, G_OPTION_ARG_DOUBLE, &limits.tmp_dirs,
+          "Temporary directories per instance", "N" },
+        { "latency", 0, 0, G_OPTION_ARG_INT, &latency,
+          "Measure the main thread latency with busy clients for S seconds", "S" },
+        { NULL }
+    };
+    GOptionContext *context = g_option_context_new("- plugin instance benchmark");
+    GError *error = NULL;
+    bool ok = true;
+
+#if !GLIB_CHECK_VERSION(2, 35, 0)
+    g_type_init();
+#endif
+    g_option_context_add_main_entries(context, entries, NULL);
+    if (!g_option_context_parse(context, &argc, &argv, &error)) {
+        g_printerr("%s\n", error->message);
+        g_clear_error(&error);
+        g_option_context_free(context);
+        return 1;
+    }
+    g_option_context_free(context);
+
+    if (client == NULL) {
+        gchar *dir = g_path_get_dirname(argv[0]);
+        client = g_build_filename(dir, "bench-client", NULL);
+        g_free(dir);
+    }
+    g_setenv("SPICE_XPI_CLIENT", client, TRUE);
+
+    s_async_calls = g_async_queue_new();
+
+    // the client policy to compare with the browser's own
+    for (size_t i = 0; i < G_N_ELEMENTS(s_policy_vars); ++i) {
+        policy[i] = g_strdup(g_getenv(s_policy_vars[i]));
+        if (policy[i] != NULL)
+            default_policy = false;
+    }
+    if (default_policy) {
+        g_free(policy[1]);
+        policy[1] = g_strdup("19");
+        g_free(policy[3]);
+        policy[3] = g_strdup("1");
+    }
+    if (latency > 0)
+        g_setenv("SPICE_XPI_BENCH_BUSY", "1", TRUE);
+
+    // the first launch sets up what GLib keeps for the whole process, such
+    // as its worker thread, it is not measured
+    if (!run_round(1, NULL, NULL, 0)) {
+        g_printerr("the stub client %s did not connect\n", client);
+        return 1;
+    }
+
+    gchar **counts = g_strsplit(instances ? instances : DEFAULT_INSTANCES, ",", 0);
+    for (gchar **it = counts; *it != NULL; ++it) {
+        char *end;
+        unsigned long count = strtoul(*it, &end, 10);
+        if (end == *it || *end != '\0' || count == 0) {
+            g_printerr("invalid number of instances: '%s'\n", *it);
+            ok = false;
+            break;
+        }
+        if (latency <= 0) {
+            ok = run_round(count, &limits, NULL, 0) && ok;
+            continue;
+        }
+
+        // the controllers read the policy, when they are created
+        for (size_t i = 0; i < G_N_ELEMENTS(s_policy_vars); ++i)
+            g_unsetenv(s_policy_vars[i]);
+        ok = run_round(count, &limits, "browser", latency) && ok;
+        for (size_t i = 0; i < G_N_ELEMENTS(s_policy_vars); ++i) {
+            if (policy[i] != NULL)
+                g_setenv(s_policy_vars[i], policy[i], TRUE);
+        }
+        ok = run_round(count, &limits, "client", latency) && ok;
+    }
+    g_strfreev(counts);
+    for (size_t i = 0; i < G_N_ELEMENTS(s_policy_vars); ++i)
+        g_free(policy[i]);
+
+    g_async_queue_unref(s_async_calls);
+    g_free(instances);
+    g_free(client);
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,188 @@
+/* Generated by spice-xpi-generator from the [controller(...)] annotations
+ * of nsISpicec.idl, do not edit. Regenerate with:
+ *   spice-xpi-generator -m controller -i nsISpicec.idl -o controller-handshake.h
+ */
+
+#ifndef SPICE_CONTROLLER_HANDSHAKE_H
+#define SPICE_CONTROLLER_HANDSHAKE_H
+
+#include <cstring>
+#include <string>
+#include <spice/controller_prot.h>
+
+// Values of the annotated attributes, serialized into the controller
+// messages of the handshake. A string, which is NULL or empty, and a
+// zero value are not sent; a bool is always sent.
+class ControllerHandshake
+{
+public:
+    enum Encoding {
+        ENCODING_STR,
+        ENCODING_VALUE,
+        ENCODING_BOOL
+    };
+
+    struct Field {
+        const char *attribute;
+        uint32_t message;
+        Encoding encoding;
+    };
+
+    // index of each attribute in Fields()
+    enum Index {
+        FIELD_hostIP,
+        FIELD_port,
+        FIELD_SecurePort,
+        FIELD_Password,
+        FIELD_CipherSuite,
+        FIELD_SSLChannels,
+        FIELD_HostSubject,
+        FIELD_fullScreen,
+        FIELD_Title,
+        FIELD_HotKey,
+        FIELD_SendCtrlAltDelete,
+        FIELD_UsbAutoShare,
+        FIELD_Smartcard,
+        FIELD_ColorDepth,
+        FIELD_DisableEffects,
+        FIELD_COUNT
+    };
+
+    // descriptor table, in the order of the messages
+    static const Field *Fields()
+    {
+        static const Field fields[FIELD_COUNT] = {
+            { "hostIP", CONTROLLER_HOST, ENCODING_STR },
+            { "port", CONTROLLER_PORT, ENCODING_VALUE },
+            { "SecurePort", CONTROLLER_SPORT, ENCODING_VALUE },
+            { "Password", CONTROLLER_PASSWORD, ENCODING_STR },
+            { "CipherSuite", CONTROLLER_TLS_CIPHERS, ENCODING_STR },
+            { "SSLChannels", CONTROLLER_SECURE_CHANNELS, ENCODING_STR },
+            { "HostSubject", CONTROLLER_HOST_SUBJECT, ENCODING_STR },
+            { "fullScreen", CONTROLLER_FULL_SCREEN, ENCODING_VALUE },
+            { "Title", CONTROLLER_SET_TITLE, ENCODING_STR },
+            { "HotKey", CONTROLLER_HOTKEYS, ENCODING_STR },
+            { "SendCtrlAltDelete", CONTROLLER_SEND_CAD, ENCODING_BOOL },
+            { "UsbAutoShare", CONTROLLER_ENABLE_USB_AUTOSHARE, ENCODING_BOOL },
+            { "Smartcard", CONTROLLER_ENABLE_SMARTCARD, ENCODING_BOOL },
+            { "ColorDepth", CONTROLLER_COLOR_DEPTH, ENCODING_VALUE },
+            { "DisableEffects", CONTROLLER_DISABLE_EFFECTS, ENCODING_STR }
+        };
+        return fields;
+    }
+
+    ControllerHandshake():
+        hostIP(NULL),
+        port(0),
+        SecurePort(0),
+        Password(NULL),
+        CipherSuite(NULL),
+        SSLChannels(NULL),
+        HostSubject(NULL),
+        fullScreen(0),
+        Title(NULL),
+        HotKey(NULL),
+        SendCtrlAltDelete(false),
+        UsbAutoShare(false),
+        Smartcard(false),
+        ColorDepth(0),
+        DisableEffects(NULL)
+    {}
+
+    const std::string *hostIP;
+    uint32_t port;
+    uint32_t SecurePort;
+    const std::string *Password;
+    const std::string *CipherSuite;
+    const std::string *SSLChannels;
+    const std::string *HostSubject;
+    uint32_t fullScreen;
+    const std::string *Title;
+    const std::string *HotKey;
+    bool SendCtrlAltDelete;
+    bool UsbAutoShare;
+    bool Smartcard;
+    uint32_t ColorDepth;
+    const std::string *DisableEffects;
+
+    // number of bytes written by Write()
+    size_t Size() const
+    {
+        size_t size = 0;
+        size += StrSize(hostIP);
+        size += port ? sizeof(ControllerValue) : 0;
+        size += SecurePort ? sizeof(ControllerValue) : 0;
+        size += StrSize(Password);
+        size += StrSize(CipherSuite);
+        size += StrSize(SSLChannels);
+        size += StrSize(HostSubject);
+        size += fullScreen ? sizeof(ControllerValue) : 0;
+        size += StrSize(Title);
+        size += StrSize(HotKey);
+        size += sizeof(ControllerValue); // SendCtrlAltDelete
+        size += sizeof(ControllerValue); // UsbAutoShare
+        size += sizeof(ControllerValue); // Smartcard
+        size += ColorDepth ? sizeof(ControllerValue) : 0;
+        size += StrSize(DisableEffects);
+        return size;
+    }
+
+    char *Write(char *buf) const
+    {
+        buf = WriteStr(buf, CONTROLLER_HOST, hostIP);
+        if (port)
+            buf = WriteValue(buf, CONTROLLER_PORT, port);
+        if (SecurePort)
+            buf = WriteValue(buf, CONTROLLER_SPORT, SecurePort);
+        buf = WriteStr(buf, CONTROLLER_PASSWORD, Password);
+        buf = WriteStr(buf, CONTROLLER_TLS_CIPHERS, CipherSuite);
+        buf = WriteStr(buf, CONTROLLER_SECURE_CHANNELS, SSLChannels);
+        buf = WriteStr(buf, CONTROLLER_HOST_SUBJECT, HostSubject);
+        if (fullScreen)
+            buf = WriteValue(buf, CONTROLLER_FULL_SCREEN, fullScreen);
+        buf = WriteStr(buf, CONTROLLER_SET_TITLE, Title);
+        buf = WriteStr(buf, CONTROLLER_HOTKEYS, HotKey);
+        buf = WriteValue(buf, CONTROLLER_SEND_CAD, SendCtrlAltDelete);
+        buf = WriteValue(buf, CONTROLLER_ENABLE_USB_AUTOSHARE, UsbAutoShare);
+        buf = WriteValue(buf, CONTROLLER_ENABLE_SMARTCARD, Smartcard);
+        if (ColorDepth)
+            buf = WriteValue(buf, CONTROLLER_COLOR_DEPTH, ColorDepth);
+        buf = WriteStr(buf, CONTROLLER_DISABLE_EFFECTS, DisableEffects);
+        return buf;
+    }
+
+    // serializes the whole handshake with a single allocation
+    void AppendTo(std::string &out) const
+    {
+        const size_t offset = out.size();
+        out.resize(offset + Size());
+        Write(&out[offset]);
+    }
+
+private:
+    static size_t StrSize(const std::string *str)
+    {
+        return str && !str->empty() ? sizeof(ControllerData) + str->size() + 1 : 0;
+    }
+
+    static char *WriteStr(char *buf, uint32_t id, const std::string *str)
+    {
+        const size_t size = StrSize(str);
+        if (!size)
+            return buf;
+
+        ControllerMsg msg = { id, static_cast<uint32_t>(size) };
+        memcpy(buf, &msg, sizeof(msg));
+        memcpy(buf + sizeof(ControllerData), str->c_str(), str->size() + 1);
+        return buf + size;
+    }
+
+    static char *WriteValue(char *buf, uint32_t id, uint32_t value)
+    {
+        ControllerValue msg = { {id, sizeof(msg)}, value };
+        memcpy(buf, &msg, sizeof(msg));
+        return buf + sizeof(msg);
+    }
+};
+
+#endif // SPICE_CONTROLLER_HANDSHAKE_H
@@ -40,6 +40,10 @@
  *   the terms of any one of the MPL, the GPL or the LGPL.
  *
  * ***** END LICENSE BLOCK ***** */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
 #include "config.h"
 
 #include <cstdio>
@@ -52,7 +56,10 @@ extern "C" {
 #  include <stdint.h>
 #  include <unistd.h>
 #  include <fcntl.h>
+#  include <sched.h>
+#  include <sys/resource.h>
 #  include <sys/socket.h>
+#  include <sys/syscall.h>
 #  include <sys/un.h>
 #  include <sys/wait.h>
 }
@@ -61,13 +68,27 @@ extern "C" {
 #include "controller-unix.h"
 #include "plugin.h"
 
+// not exported by glibc, see linux/ioprio.h
+#define IOPRIO_CLASS_SHIFT      13
+#define IOPRIO_CLASS_BE         2
+#define IOPRIO_CLASS_IDLE       3
+#define IOPRIO_WHO_PROCESS      1
+#define IOPRIO_PRIO_VALUE(class, data) (((class) << IOPRIO_CLASS_SHIFT) | (data))
+
 SpiceControllerUnix::SpiceControllerUnix(nsPluginInstance *aPlugin):
     SpiceController(aPlugin),
-    m_client_socket(-1)
+    m_client_socket(-1),
+    m_set_cpu_affinity(false),
+    m_set_nice(false),
+    m_nice(0),
+    m_ioprio(-1),
+    m_sched_batch(false)
 {
     // create temporary directory in /tmp
     char tmp_dir[] = "/tmp/spicec-XXXXXX";
     m_tmp_dir = mkdtemp(tmp_dir);
+
+    ReadSchedulingConfig();
 }
 
 SpiceControllerUnix::~SpiceControllerUnix()
@@ -103,9 +124,11 @@ int SpiceControllerUnix::Connect()
     int rc = connect(m_client_socket, (struct sockaddr *) &remote, strlen(remote.sun_path) + sizeof(remote.sun_family));
     if (rc == -1)
     {
+        // retried until the connect timeout expires, see SpiceController::Connect()
         if (errno == EISCONN)
             rc = 1;
-        g_critical("controller connect: %s", g_strerror(errno));
+        else
+            g_debug("controller connect: %s", g_strerror(errno));
     }
     else
     {
@@ -117,11 +140,15 @@ int SpiceControllerUnix::Connect()
 
 bool SpiceControllerUnix::CheckPipe()
 {
+    return m_client_socket != -1;
 }
 
+// SPICE_XPI_CLIENT replaces the client, e.g. by the stub client of
+// bench-instances; the fallback is still spicec
 GStrv SpiceControllerUnix::GetClientPath()
 {
-    const char *client_argv[] = { "/usr/libexec/spice-xpi-client", NULL };
+    const char *client = g_getenv("SPICE_XPI_CLIENT");
+    const char *client_argv[] = { client ? client : "/usr/libexec/spice-xpi-client", NULL };
 
     return g_strdupv((GStrv)client_argv);
 }
@@ -133,6 +160,101 @@ GStrv SpiceControllerUnix::GetFallbackClientPath()
     return g_strdupv((GStrv)fallback_argv);
 }
 
+// parses a cpu list, such as "0-1,3"
+static bool parse_cpu_list(const char *list, cpu_set_t *cpus)
+{
+    gchar **ranges = g_strsplit(list, ",", -1);
+    bool ok = true;
+
+    CPU_ZERO(cpus);
+    for (gchar **range = ranges; *range != NULL && ok; ++range) {
+        char *end;
+        unsigned long first = strtoul(*range, &end, 10);
+        unsigned long last = first;
+        if (end == *range) {
+            ok = false;
+            break;
+        }
+        if (*end == '-') {
+            const char *start = end + 1;
+            last = strtoul(start, &end, 10);
+            if (end == start)
+                ok = false;
+        }
+        if (*end != '\0' || last < first || last >= CPU_SETSIZE)
+            ok = false;
+        for (unsigned long cpu = first; ok && cpu <= last; ++cpu)
+            CPU_SET(cpu, cpus);
+    }
+    g_strfreev(ranges);
+
+    return ok && CPU_COUNT(cpus) > 0;
+}
+
+// The client scheduling policy is plugin-wide and is read from the
+// environment:
+//   SPICE_XPI_CLIENT_CPU_AFFINITY  cpu list, e.g. "2-3"
+//   SPICE_XPI_CLIENT_NICE          nice value, -20..19
+//   SPICE_XPI_CLIENT_IOPRIO        "idle" or best-effort level 0..7
+//   SPICE_XPI_CLIENT_SCHED_BATCH   set to run the client with SCHED_BATCH
+void SpiceControllerUnix::ReadSchedulingConfig()
+{
+    const char *value;
+
+    value = g_getenv("SPICE_XPI_CLIENT_CPU_AFFINITY");
+    if (value != NULL) {
+        m_set_cpu_affinity = parse_cpu_list(value, &m_cpu_affinity);
+        if (!m_set_cpu_affinity)
+            g_warning("invalid client cpu affinity: '%s'", value);
+    }
+
+    value = g_getenv("SPICE_XPI_CLIENT_NICE");
+    if (value != NULL) {
+        char *end;
+        long nice = strtol(value, &end, 10);
+        m_set_nice = (end != value && *end == '\0' && nice >= -20 && nice <= 19);
+        m_nice = nice;
+        if (!m_set_nice)
+            g_warning("invalid client nice value: '%s'", value);
+    }
+
+    value = g_getenv("SPICE_XPI_CLIENT_IOPRIO");
+    if (value != NULL) {
+        char *end;
+        long level = strtol(value, &end, 10);
+        if (g_strcmp0(value, "idle") == 0)
+            m_ioprio = IOPRIO_PRIO_VALUE(IOPRIO_CLASS_IDLE, 0);
+        else if (end != value && *end == '\0' && level >= 0 && level <= 7)
+            m_ioprio = IOPRIO_PRIO_VALUE(IOPRIO_CLASS_BE, level);
+        else
+            g_warning("invalid client I/O priority: '%s'", value);
+    }
+
+    m_sched_batch = (g_getenv("SPICE_XPI_CLIENT_SCHED_BATCH") != NULL);
+}
+
+// runs in the forked client, right before exec, so only async-signal-safe
+// calls are allowed here; failures are not fatal, the client just runs
+// with the inherited policy
+void SpiceControllerUnix::SetupClientProcess()
+{
+    if (m_set_cpu_affinity)
+        sched_setaffinity(0, sizeof(m_cpu_affinity), &m_cpu_affinity);
+
+    if (m_sched_batch) {
+        struct sched_param param = { 0 };
+        sched_setscheduler(0, SCHED_BATCH, &param);
+    }
+
+    if (m_set_nice)
+        setpriority(PRIO_PROCESS, 0, m_nice);
+
+#ifdef SYS_ioprio_set
+    if (m_ioprio >= 0)
+        syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, 0, m_ioprio);
+#endif
+}
+
 void SpiceControllerUnix::SetupControllerPipe(GStrv &env)
 {
     std::string socket_file(this->m_tmp_dir);
@@ -143,15 +265,31 @@ void SpiceControllerUnix::SetupControllerPipe(GStrv &env)
     env = g_environ_setenv(env, "SPICE_XPI_SOCKET", socket_file.c_str(), TRUE);
 }
 
-void SpiceControllerUnix::StopClient()
+static void kill_client(GPid pid, int sig)
+{
+    // the client is expected to lead its own process group, signal only
+    // the client itself, if it doesn't
+    if (kill(-pid, sig) != 0 && errno == ESRCH)
+        kill(pid, sig);
+}
+
+void SpiceControllerUnix::TerminateClient()
+{
+    if (m_pid_controller > 0)
+        kill_client(m_pid_controller, SIGTERM);
+}
+
+void SpiceControllerUnix::KillClient()
 {
     if (m_pid_controller > 0)
-        kill(-m_pid_controller, SIGTERM);
+        kill_client(m_pid_controller, SIGKILL);
 }
 
 uint32_t SpiceControllerUnix::Write(const void *lpBuffer, uint32_t nBytesToWrite)
 {
-    ssize_t len = send(m_client_socket, lpBuffer, nBytesToWrite, 0);
+    // the client may go away at any time, e.g. while a property is being
+    // pushed to it, so don't let a broken socket raise SIGPIPE in the browser
+    ssize_t len = send(m_client_socket, lpBuffer, nBytesToWrite, MSG_NOSIGNAL);
 
     if (len != (ssize_t)nBytesToWrite)
     {
@@ -67,6 +67,7 @@ extern "C" {
 #  include <limits.h>
 }
 
+#include <sched.h>
 #include <spice/controller_prot.h>
 #include "controller.h"
 
@@ -78,20 +79,32 @@ public:
     SpiceControllerUnix(nsPluginInstance *aPlugin);
     virtual ~SpiceControllerUnix();
 
-    virtual void StopClient();
     virtual uint32_t Write(const void *lpBuffer, uint32_t nBytesToWrite);
-    int Connect(int nRetries) { return SpiceController::Connect(nRetries); };
+    int Connect(GCancellable *cancellable, gint64 deadline) { return SpiceController::Connect(cancellable, deadline); };
 
 private:
     virtual int Connect();
+    virtual void TerminateClient();
+    virtual void KillClient();
     virtual void Disconnect();
     virtual void SetupControllerPipe(GStrv &env);
     virtual bool CheckPipe();
     virtual GStrv GetClientPath(void);
     virtual GStrv GetFallbackClientPath(void);
+    virtual void SetupClientProcess();
+    void ReadSchedulingConfig();
 
     int m_client_socket;
     std::string m_tmp_dir;
+
+    // scheduling policy applied to the spawned client, see
+    // ReadSchedulingConfig()
+    bool m_set_cpu_affinity;
+    cpu_set_t m_cpu_affinity;
+    bool m_set_nice;
+    int m_nice;
+    int m_ioprio;
+    bool m_sched_batch;
 };
 
 #endif // SPICE_CONTROLLER_UNIX_H
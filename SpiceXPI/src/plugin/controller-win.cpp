@@ -75,7 +75,11 @@ int SpiceControllerWin::Connect()
                              OPEN_EXISTING,
                              SECURITY_SQOS_PRESENT | SECURITY_ANONYMOUS,
                              NULL);
-    g_return_val_if_fail(hClientPipe != INVALID_HANDLE_VALUE, -1);
+    // retried until the connect timeout expires, see SpiceController::Connect()
+    if (hClientPipe == INVALID_HANDLE_VALUE) {
+        g_debug("controller connect: error %lu", GetLastError());
+        return -1;
+    }
 
     g_warning("Connection OK");
     m_pipe = g_win32_output_stream_new(hClientPipe, TRUE);
@@ -186,6 +190,12 @@ GStrv SpiceControllerWin::GetFallbackClientPath()
     return fallback_argv;
 }
 
+void SpiceControllerWin::SetupClientProcess()
+{
+    // on Windows, this runs in the plugin process before the client is
+    // created, so there is nothing to set up here
+}
+
 #define RED_CLIENT_PIPE_NAME TEXT("\\\\.\\pipe\\SpiceController-%lu")
 void SpiceControllerWin::SetupControllerPipe(GStrv &env)
 {
@@ -196,7 +206,7 @@ void SpiceControllerWin::SetupControllerPipe(GStrv &env)
     g_free(pipe_name);
 }
 
-void SpiceControllerWin::StopClient()
+void SpiceControllerWin::TerminateClient()
 {
     if (m_pid_controller != NULL) {
         //WaitForPid will take care of closing the handle
@@ -205,6 +215,11 @@ void SpiceControllerWin::StopClient()
     }
 }
 
+void SpiceControllerWin::KillClient()
+{
+    // TerminateProcess() is not graceful, there is nothing to escalate to
+}
+
 
 uint32_t SpiceControllerWin::Write(const void *lpBuffer, uint32_t nBytesToWrite)
 {
@@ -78,16 +78,18 @@ public:
     SpiceControllerWin(nsPluginInstance *aPlugin);
     virtual ~SpiceControllerWin();
 
-    virtual void StopClient();
     virtual uint32_t Write(const void *lpBuffer, uint32_t nBytesToWrite);
-    int Connect(int nRetries) { return SpiceController::Connect(nRetries); };
+    int Connect(GCancellable *cancellable, gint64 deadline) { return SpiceController::Connect(cancellable, deadline); };
 
 private:
     virtual int Connect();
+    virtual void TerminateClient();
+    virtual void KillClient();
     virtual void SetupControllerPipe(GStrv &env);
     virtual bool CheckPipe();
     virtual GStrv GetClientPath(void);
     virtual GStrv GetFallbackClientPath(void);
+    virtual void SetupClientProcess();
 };
 
 #endif // SPICE_CONTROLLER_WIN_H
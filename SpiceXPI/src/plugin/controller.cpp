@@ -54,18 +54,96 @@
 #include "controller.h"
 #include "plugin.h"
 
+// time given to the client to exit on its own, before it gets killed
+#define DEFAULT_SHUTDOWN_TIMEOUT 3000 // ms
+
+// time given to a killed client to be reaped, when the plugin is unloaded
+#define DETACHED_EXIT_MARGIN 1000 // ms
+
+// how long to wait for the client to be started and to open its
+// controller socket, unless set by the ConnectTimeout property
+#define DEFAULT_CONNECT_TIMEOUT 10000 // ms
+#define CONNECT_RETRY_INTERVAL 100 // ms
+
+// how long the server may take to accept a probe connection, 0 disables
+// the probe
+#define DEFAULT_PROBE_TIMEOUT 0 // ms
+
+// how much of the client's output is kept, 0 leaves it on the browser's
+// stdout and stderr
+#define DEFAULT_CLIENT_LOG_SIZE 16384 // bytes
+
+// how many clients may be spawned and waited for at once
+#define DEFAULT_MAX_PARALLEL_LAUNCHES 4
+
+GMutex SpiceController::s_launch_lock;
+GCond SpiceController::s_launch_cond;
+int SpiceController::s_launches = 0;
+
+GMutex SpiceController::s_detached_lock;
+GCond SpiceController::s_detached_cond;
+int SpiceController::s_detached = 0;
+gint64 SpiceController::s_detached_deadline = 0;
+int SpiceController::s_max_launches = 0;
+
 SpiceController::SpiceController(nsPluginInstance *aPlugin):
     m_pid_controller(0),
     m_pipe(NULL),
     m_plugin(aPlugin),
-    m_child_watch_mainloop(NULL)
+    m_client_thread(NULL),
+    m_child_watch_mainloop(NULL),
+    m_client_context(NULL),
+    m_detached(false),
+    m_thread_done(false),
+    m_stop_time(0),
+    m_shutdown_timeout(DEFAULT_SHUTDOWN_TIMEOUT),
+    m_probe_port(0),
+    m_probe_sport(0),
+    m_probe_timeout(DEFAULT_PROBE_TIMEOUT),
+    m_probe_context(NULL),
+    m_probe_cancellable(NULL),
+    m_probe_timeout_source(NULL),
+    m_probe_pending(0),
+    m_probe_reachable(false),
+    m_probe_cancelled_id(0),
+    m_connect_timeout(DEFAULT_CONNECT_TIMEOUT),
+    m_connect_deadline(0),
+    m_cancellable(NULL),
+    m_failure_code(0),
+    m_attempt(0),
+    m_state(STATE_IDLE),
+    m_state_epoch(0),
+    m_state_history_len(0),
+    m_log(DEFAULT_CLIENT_LOG_SIZE),
+    m_log_start(0),
+    m_log_len(0)
 {
+    memset(m_state_history, 0, sizeof(m_state_history));
+    m_log_channels[0] = m_log_channels[1] = NULL;
+    g_mutex_init(&m_lock);
+    g_mutex_init(&m_log_lock);
+
+    const char *timeout = g_getenv("SPICE_XPI_SHUTDOWN_TIMEOUT");
+    if (timeout != NULL)
+        m_shutdown_timeout = strtoul(timeout, NULL, 10);
+
+    timeout = g_getenv("SPICE_XPI_PROBE_TIMEOUT");
+    if (timeout != NULL)
+        m_probe_timeout = strtoul(timeout, NULL, 10);
+
+    const char *log_size = g_getenv("SPICE_XPI_CLIENT_LOG_SIZE");
+    if (log_size != NULL)
+        m_log.resize(strtoul(log_size, NULL, 10));
 }
 
 SpiceController::~SpiceController()
 {
     g_debug("%s", G_STRFUNC);
     Disconnect();
+    if (m_cancellable != NULL)
+        g_object_unref(m_cancellable);
+    g_mutex_clear(&m_lock);
+    g_mutex_clear(&m_log_lock);
 }
 
 void SpiceController::SetFilename(const std::string &name)
@@ -78,6 +156,127 @@ void SpiceController::SetProxy(const std::string &proxy)
     m_proxy = proxy;
 }
 
+// messages written by the client thread as soon as the controller socket
+// is connected
+void SpiceController::SetHandshake(const std::string &handshake)
+{
+    m_handshake = handshake;
+}
+
+const char *SpiceController::GetStateName(State state)
+{
+    static const char *names[] = {
+        "idle",
+        "spawning",
+        "waiting-socket",
+        "handshaking",
+        "connected",
+        "exiting",
+        "exited"
+    };
+
+    if ((unsigned int)state >= G_N_ELEMENTS(names))
+        return "unknown";
+
+    return names[state];
+}
+
+void SpiceController::RecordState(State state)
+{
+    gint64 elapsed = (g_get_monotonic_time() - m_state_epoch) / 1000;
+    int index;
+
+    if (elapsed > G_MAXINT >> 3)
+        elapsed = G_MAXINT >> 3;
+    index = g_atomic_int_add(&m_state_history_len, 1) % STATE_HISTORY_SIZE;
+    g_atomic_int_set(&m_state_history[index], (gint)(elapsed << 3) | state);
+}
+
+void SpiceController::SetState(State state)
+{
+    g_atomic_int_set(&m_state, state);
+    RecordState(state);
+}
+
+// moves to a new state, unless the state has changed meanwhile, e.g.
+// because StopClient() was called from another thread
+bool SpiceController::SetState(State from, State to)
+{
+    if (!g_atomic_int_compare_and_exchange(&m_state, from, to))
+        return false;
+    RecordState(to);
+
+    return true;
+}
+
+// the transitions of the current connection attempt, oldest first,
+// e.g. "spawning +0 ms, waiting-socket +12 ms, ..."
+std::string SpiceController::GetStateHistory() const
+{
+    const int len = g_atomic_int_get(&m_state_history_len);
+    std::string history;
+
+    for (int i = MAX(0, len - STATE_HISTORY_SIZE); i < len; ++i) {
+        const gint entry = g_atomic_int_get(&m_state_history[i % STATE_HISTORY_SIZE]);
+        gchar *str = g_strdup_printf("%s%s +%d ms", history.empty() ? "" : ", ",
+                                     GetStateName((State)(entry & 7)), entry >> 3);
+        history += str;
+        g_free(str);
+    }
+
+    return history;
+}
+
+// server the client is going to connect to; a port <= 0 is not probed
+void SpiceController::SetProbe(const std::string &host, int port, int sport)
+{
+    m_probe_host = host;
+    m_probe_port = port;
+    m_probe_sport = sport;
+}
+
+// 0 restores the default timeout
+void SpiceController::SetConnectTimeout(guint timeout)
+{
+    m_connect_timeout = timeout ? timeout : DEFAULT_CONNECT_TIMEOUT;
+}
+
+static gboolean wake_up(gpointer user_data)
+{
+    return TRUE;
+}
+
+static gboolean wake_up_cancelled(GCancellable *cancellable, gpointer user_data)
+{
+    return TRUE;
+}
+
+// runs the client thread's context for timeout ms, so that the client's
+// output is read meanwhile; returns true as soon as cancellable is
+// cancelled
+bool SpiceController::IterateClientContext(GCancellable *cancellable, guint timeout)
+{
+    const gint64 end = g_get_monotonic_time() + timeout * G_GINT64_CONSTANT(1000);
+    GSource *timeout_source = g_timeout_source_new(timeout);
+    GSource *cancel_source = g_cancellable_source_new(cancellable);
+
+    g_source_set_callback(timeout_source, wake_up, NULL, NULL);
+    g_source_attach(timeout_source, m_client_context);
+    g_source_set_callback(cancel_source, (GSourceFunc)wake_up_cancelled, NULL, NULL);
+    g_source_attach(cancel_source, m_client_context);
+
+    while (!g_cancellable_is_cancelled(cancellable) &&
+           g_get_monotonic_time() < end)
+        g_main_context_iteration(m_client_context, TRUE);
+
+    g_source_destroy(cancel_source);
+    g_source_unref(cancel_source);
+    g_source_destroy(timeout_source);
+    g_source_unref(timeout_source);
+
+    return g_cancellable_is_cancelled(cancellable);
+}
+
 #define FACILITY_SPICEX             50
 #define FACILITY_CREATE_RED_PROCESS 51
 #define FACILITY_STRING_OPERATION   52
@@ -85,85 +284,558 @@ void SpiceController::SetProxy(const std::string &proxy)
 #define FACILITY_CREATE_RED_PIPE    54
 #define FACILITY_PIPE_OPERATION     55
 
-int SpiceController::Connect(const int nRetries)
+// Waits for the client's controller socket until the deadline, or until
+// the connection attempt is cancelled; the caller stops a client which
+// could not be connected to
+int SpiceController::Connect(GCancellable *cancellable, gint64 deadline)
 {
     int rc = -1;
-    int sleep_time = 1;
 
-    // try to connect for specified count
-    for (int i = 0; rc != 0 && i < nRetries; ++i)
+    for (;;)
     {
         rc = Connect();
         if (rc == 1)
+            rc = 0;
+        if (rc == 0 || g_get_monotonic_time() >= deadline)
             break;
-        g_usleep(sleep_time * G_USEC_PER_SEC);
+        if (IterateClientContext(cancellable, CONNECT_RETRY_INTERVAL))
+            return -1;
     }
     if (rc != 0) {
-        g_warning("error connecting");
+        // the failed attempts are only logged as debug messages
+        g_critical("client did not connect within %u ms", m_connect_timeout);
         g_assert(m_pipe == NULL);
-    }
-    if (!CheckPipe()) {
+    } else if (!CheckPipe()) {
         g_warning("Pipe validation failure");
         g_warn_if_fail(m_pipe == NULL);
+        rc = -1;
     }
-    if (m_pipe == NULL) {
+    if (rc != 0) {
         g_warning("failed to create pipe");
 #ifdef XP_WIN
         rc = MAKE_HRESULT(1, FACILITY_CREATE_RED_PIPE, GetLastError());
 #endif
-        this->StopClient();
     }
 
     return rc;
 }
 
+// Limits the number of clients being launched at once, so that a page
+// opening many consoles doesn't spawn all of them in the same instant.
+// The limit can be set by SPICE_XPI_MAX_PARALLEL_LAUNCHES. Gives up when
+// the deadline passes or the launch is cancelled.
+bool SpiceController::AcquireLaunchSlot(GCancellable *cancellable, gint64 deadline)
+{
+    bool acquired;
+
+    g_mutex_lock(&s_launch_lock);
+    if (s_max_launches == 0) {
+        const char *max = g_getenv("SPICE_XPI_MAX_PARALLEL_LAUNCHES");
+        s_max_launches = max ? atoi(max) : 0;
+        if (s_max_launches <= 0)
+            s_max_launches = DEFAULT_MAX_PARALLEL_LAUNCHES;
+    }
+    while (s_launches >= s_max_launches &&
+           !g_cancellable_is_cancelled(cancellable) &&
+           g_get_monotonic_time() < deadline)
+        g_cond_wait_until(&s_launch_cond, &s_launch_lock, deadline);
+    acquired = s_launches < s_max_launches &&
+               !g_cancellable_is_cancelled(cancellable);
+    if (acquired)
+        ++s_launches;
+    g_mutex_unlock(&s_launch_lock);
+
+    return acquired;
+}
+
+void SpiceController::ReleaseLaunchSlot()
+{
+    g_mutex_lock(&s_launch_lock);
+    --s_launches;
+    // cancelled waiters leave without taking the slot, wake everyone
+    g_cond_broadcast(&s_launch_cond);
+    g_mutex_unlock(&s_launch_lock);
+}
+
 void SpiceController::Disconnect()
 {
 }
 
+// Asks the client to exit and gives it m_shutdown_timeout ms to do so,
+// after which it gets killed. The client is reaped by the child watch
+// in the client thread, as usual. A client still being started is not
+// waited for any longer.
+void SpiceController::StopClient()
+{
+    State state = GetState();
+
+    while (state != STATE_IDLE && state != STATE_EXITING &&
+           state != STATE_EXITED && !SetState(state, STATE_EXITING))
+        state = GetState();
+
+    g_mutex_lock(&m_lock);
+    if (m_stop_time == 0) {
+        m_stop_time = g_get_monotonic_time();
+        TerminateClient();
+        ArmShutdownTimeout();
+    }
+    if (m_cancellable != NULL)
+        g_cancellable_cancel(m_cancellable);
+    g_mutex_unlock(&m_lock);
+
+    // wake up the client thread, if it waits for a launch slot
+    g_mutex_lock(&s_launch_lock);
+    g_cond_broadcast(&s_launch_cond);
+    g_mutex_unlock(&s_launch_lock);
+}
+
+// Stops the client and deletes the controller. The client thread is not
+// waited for, closing a page with many clients would freeze the browser
+// for the shutdown timeout of each of them; the thread deletes the
+// controller itself once the client has exited. The exit is not reported
+// to the plugin instance any more.
+void SpiceController::Shutdown()
+{
+    g_mutex_lock(&m_lock);
+    m_plugin = NULL;
+    g_mutex_unlock(&m_lock);
+
+    if (m_client_thread == NULL) {
+        delete this;
+        return;
+    }
+
+    StopClient();
+
+    g_mutex_lock(&s_detached_lock);
+    s_detached++;
+    s_detached_deadline = MAX(s_detached_deadline,
+                              g_get_monotonic_time() +
+                              (m_shutdown_timeout + DETACHED_EXIT_MARGIN) *
+                              G_GINT64_CONSTANT(1000));
+    g_mutex_unlock(&s_detached_lock);
+
+    g_mutex_lock(&m_lock);
+    m_detached = true;
+    const bool done = m_thread_done;
+    g_mutex_unlock(&m_lock);
+
+    if (done) {
+        g_thread_join(m_client_thread);
+        DeleteDetached(this);
+    } else {
+        g_thread_unref(m_client_thread);
+    }
+}
+
+void SpiceController::DeleteDetached(SpiceController *controller)
+{
+    delete controller;
+
+    g_mutex_lock(&s_detached_lock);
+    s_detached--;
+    g_cond_broadcast(&s_detached_cond);
+    g_mutex_unlock(&s_detached_lock);
+}
+
+// Waits for the client threads left behind by Shutdown(), they run the
+// plugin's code until their clients have exited. Called once, when the
+// plugin is unloaded, so that all the clients are waited for at once.
+void SpiceController::WaitForDetached()
+{
+    g_mutex_lock(&s_detached_lock);
+    while (s_detached > 0) {
+        if (!g_cond_wait_until(&s_detached_cond, &s_detached_lock,
+                               s_detached_deadline))
+            break;
+    }
+    if (s_detached > 0)
+        g_warning("%d client threads still running at plugin shutdown", s_detached);
+    g_mutex_unlock(&s_detached_lock);
+}
+
+// must be called with m_lock held; does nothing until the client is
+// being watched, WaitForPid() arms the timeout itself in such case
+void SpiceController::ArmShutdownTimeout()
+{
+    if (m_child_watch_mainloop == NULL)
+        return;
+
+    GSource *source = g_timeout_source_new(m_shutdown_timeout);
+    g_source_set_callback(source, ShutdownTimeout, this, NULL);
+    g_source_attach(source, g_main_loop_get_context(m_child_watch_mainloop));
+    g_source_unref(source);
+}
+
+gboolean SpiceController::ShutdownTimeout(gpointer user_data)
+{
+    SpiceController *fake_this = (SpiceController *)user_data;
+
+    g_warning("client did not exit within %u ms, killing it",
+              fake_this->m_shutdown_timeout);
+    g_mutex_lock(&fake_this->m_lock);
+    fake_this->KillClient();
+    g_mutex_unlock(&fake_this->m_lock);
+
+    return FALSE;
+}
+
 void SpiceController::ChildExited(GPid pid, gint status, gpointer user_data)
 {
     SpiceController *fake_this = (SpiceController *)user_data;
 
-    g_message("Client with pid %p exited", pid);
+    g_mutex_lock(&fake_this->m_lock);
+    if (fake_this->m_stop_time != 0) {
+        g_message("Client with pid %p exited, shutdown took %.1f ms", pid,
+                  (g_get_monotonic_time() - fake_this->m_stop_time) / 1000.0);
+    } else {
+        g_message("Client with pid %p exited", pid);
+    }
 
     g_main_loop_quit(fake_this->m_child_watch_mainloop);
-    /* FIXME: we are not in the main thread!! */
-    fake_this->m_plugin->OnSpiceClientExit(status);
+    fake_this->SetState(STATE_EXITED);
+
+    // an exit we haven't asked for is worth a look at what the client said
+    if (status != 0 && fake_this->m_stop_time == 0)
+        fake_this->DumpClientLog();
+    // a client stopped by a failed probe or by the connect timeout
+    // never got to connect
+    if (fake_this->m_failure_code != 0)
+        status = fake_this->m_failure_code;
+
+    // the plugin instance only takes note of the exit and passes it on to
+    // the main thread; the lock keeps the instance from going away meanwhile
+    if (fake_this->m_plugin != NULL)
+        fake_this->m_plugin->OnSpiceClientExit(status);
+    g_mutex_unlock(&fake_this->m_lock);
 }
 
 void SpiceController::WaitForPid(GPid pid)
 {
-    GMainContext *context;
+    GMainContext *context = m_client_context;
     GSource *source;
 
-    context = g_main_context_new();
-
+    g_mutex_lock(&m_lock);
     m_child_watch_mainloop = g_main_loop_new(context, FALSE);
+    // the client may have been asked to stop before we started watching it
+    if (m_stop_time != 0)
+        ArmShutdownTimeout();
+    g_mutex_unlock(&m_lock);
+
     source = g_child_watch_source_new(pid);
     g_source_set_callback(source, (GSourceFunc)ChildExited, this, NULL);
     g_source_attach(source, context);
+    g_source_unref(source);
 
     g_main_loop_run(m_child_watch_mainloop);
 
-    g_main_loop_unref(m_child_watch_mainloop);
-    g_main_context_unref(context);
+    for (unsigned int i = 0; i < G_N_ELEMENTS(m_log_channels); ++i) {
+        if (m_log_channels[i] == NULL)
+            continue;
+        g_io_channel_unref(m_log_channels[i]);
+        m_log_channels[i] = NULL;
+    }
 
+    g_mutex_lock(&m_lock);
+    g_main_loop_unref(m_child_watch_mainloop);
+    m_child_watch_mainloop = NULL;
     g_spawn_close_pid(pid);
     if (pid == m_pid_controller)
         m_pid_controller = 0;
+    m_stop_time = 0;
+    g_mutex_unlock(&m_lock);
+}
+
+// the client's output is read from the spawn on, the pipes would fill up
+// while the client thread waits for the controller socket otherwise
+void SpiceController::WatchClientOutput(int out_fd, int err_fd)
+{
+    const int fds[] = { out_fd, err_fd };
+
+    for (unsigned int i = 0; i < G_N_ELEMENTS(fds); ++i) {
+#if defined(XP_WIN)
+        m_log_channels[i] = g_io_channel_win32_new_fd(fds[i]);
+#else
+        m_log_channels[i] = g_io_channel_unix_new(fds[i]);
+#endif
+        g_io_channel_set_close_on_unref(m_log_channels[i], TRUE);
+        g_io_channel_set_encoding(m_log_channels[i], NULL, NULL);
+        g_io_channel_set_buffered(m_log_channels[i], FALSE);
+        g_io_channel_set_flags(m_log_channels[i], G_IO_FLAG_NONBLOCK, NULL);
+
+        GSource *source = g_io_create_watch(m_log_channels[i],
+                                            (GIOCondition)(G_IO_IN | G_IO_HUP | G_IO_ERR));
+        g_source_set_callback(source, (GSourceFunc)ClientOutput, this, NULL);
+        g_source_attach(source, m_client_context);
+        g_source_unref(source);
+    }
+}
+
+gboolean SpiceController::ClientOutput(GIOChannel *channel, GIOCondition condition,
+                                       gpointer user_data)
+{
+    SpiceController *fake_this = (SpiceController *)user_data;
+
+    return fake_this->DrainClientOutput(channel);
+}
+
+// reads whatever the client has written so far, returns false once the
+// client has closed the pipe
+bool SpiceController::DrainClientOutput(GIOChannel *channel)
+{
+    gchar buffer[4096];
+    gsize count;
+
+    for (;;) {
+        GIOStatus status = g_io_channel_read_chars(channel, buffer, sizeof(buffer),
+                                                   &count, NULL);
+        if (count > 0)
+            AppendClientLog(buffer, count);
+        if (status == G_IO_STATUS_AGAIN)
+            return true;
+        if (status != G_IO_STATUS_NORMAL)
+            return false;
+    }
+}
+
+void SpiceController::AppendClientLog(const char *data, size_t size)
+{
+    const size_t capacity = m_log.size();
+
+    // only the tail of a chunk larger than the whole buffer is kept
+    if (size > capacity) {
+        data += size - capacity;
+        size = capacity;
+    }
+
+    g_mutex_lock(&m_log_lock);
+    const size_t end = (m_log_start + m_log_len) % capacity;
+    const size_t first = MIN(size, capacity - end);
+    memcpy(&m_log[end], data, first);
+    memcpy(&m_log[0], data + first, size - first);
+    m_log_len += size;
+    if (m_log_len > capacity) {
+        m_log_start = (m_log_start + m_log_len - capacity) % capacity;
+        m_log_len = capacity;
+    }
+    g_mutex_unlock(&m_log_lock);
+}
+
+std::string SpiceController::GetClientLog() const
+{
+    std::string log;
+
+    g_mutex_lock(&m_log_lock);
+    if (m_log_len > 0) {
+        const size_t first = MIN(m_log_len, m_log.size() - m_log_start);
+        log.reserve(m_log_len);
+        log.append(&m_log[m_log_start], first);
+        log.append(&m_log[0], m_log_len - first);
+    }
+    g_mutex_unlock(&m_log_lock);
+
+    return log;
+}
+
+void SpiceController::DumpClientLog()
+{
+    for (unsigned int i = 0; i < G_N_ELEMENTS(m_log_channels); ++i) {
+        if (m_log_channels[i] != NULL)
+            DrainClientOutput(m_log_channels[i]);
+    }
+
+    std::string log = GetClientLog();
+    if (!log.empty())
+        g_warning("client output:\n%s", log.c_str());
+}
+
+static void cancel_probe(GCancellable *cancellable, gpointer user_data)
+{
+    g_cancellable_cancel(G_CANCELLABLE(user_data));
+}
+
+// Starts connecting to the server ports in the background, so that an
+// unreachable server is noticed while the client is still being spawned.
+// The connections are driven by the client thread's context.
+// There is nothing to probe when the client goes through a proxy.
+
+void SpiceController::StartProbe(GCancellable *cancellable)
+{
+    const int ports[] = { m_probe_port, m_probe_sport };
+    GSocketClient *client;
+
+    m_probe_pending = 0;
+    m_probe_reachable = false;
+    if (m_probe_timeout == 0 || m_probe_host.empty() || !m_proxy.empty())
+        return;
+
+    m_probe_context = g_main_context_ref(m_client_context);
+    m_probe_cancellable = g_cancellable_new();
+    m_probe_cancelled_id = g_cancellable_connect(cancellable,
+                                                 G_CALLBACK(cancel_probe),
+                                                 m_probe_cancellable, NULL);
+
+    g_main_context_push_thread_default(m_probe_context);
+    client = g_socket_client_new();
+    for (unsigned int i = 0; i < G_N_ELEMENTS(ports); ++i) {
+        if (ports[i] <= 0)
+            continue;
+        g_socket_client_connect_to_host_async(client, m_probe_host.c_str(),
+                                              ports[i], m_probe_cancellable,
+                                              ProbeConnected, this);
+        ++m_probe_pending;
+    }
+    g_object_unref(client);
+    g_main_context_pop_thread_default(m_probe_context);
+
+    m_probe_timeout_source = g_timeout_source_new(m_probe_timeout);
+    g_source_set_callback(m_probe_timeout_source, ProbeTimeout, this, NULL);
+    g_source_attach(m_probe_timeout_source, m_probe_context);
+}
+
+// true if the probe is already known to have failed, does not block
+bool SpiceController::ProbeFailed()
+{
+    if (m_probe_context == NULL)
+        return false;
+
+    while (g_main_context_iteration(m_probe_context, FALSE))
+        ;
+
+    return m_probe_pending == 0 && !m_probe_reachable;
+}
+
+// waits for the probe to complete, returns false if none of the server
+// ports could be connected to within m_probe_timeout ms
+bool SpiceController::FinishProbe(GCancellable *cancellable)
+{
+    if (m_probe_context == NULL)
+        return true;
+
+    while (m_probe_pending > 0)
+        g_main_context_iteration(m_probe_context, TRUE);
+
+    g_cancellable_disconnect(cancellable, m_probe_cancelled_id);
+    m_probe_cancelled_id = 0;
+    g_source_destroy(m_probe_timeout_source);
+    g_source_unref(m_probe_timeout_source);
+    m_probe_timeout_source = NULL;
+    g_object_unref(m_probe_cancellable);
+    m_probe_cancellable = NULL;
+    g_main_context_unref(m_probe_context);
+    m_probe_context = NULL;
+
+    return m_probe_reachable;
+}
+
+void SpiceController::ProbeConnected(GObject *source, GAsyncResult *result, gpointer user_data)
+{
+    SpiceController *fake_this = (SpiceController *)user_data;
+    GSocketConnection *connection;
+    GError *error = NULL;
+
+    connection = g_socket_client_connect_to_host_finish(G_SOCKET_CLIENT(source),
+                                                        result, &error);
+    if (connection != NULL) {
+        fake_this->m_probe_reachable = true;
+        // one reachable port is enough
+        g_cancellable_cancel(fake_this->m_probe_cancellable);
+        g_object_unref(connection);
+    } else {
+        g_debug("server probe failed: %s", error->message);
+        g_clear_error(&error);
+    }
+    --fake_this->m_probe_pending;
+}
+
+gboolean SpiceController::ProbeTimeout(gpointer user_data)
+{
+    SpiceController *fake_this = (SpiceController *)user_data;
+
+    g_debug("server probe timed out after %u ms", fake_this->m_probe_timeout);
+    g_cancellable_cancel(fake_this->m_probe_cancellable);
+
+    return FALSE;
+}
+
+void SpiceController::ClientSetup(gpointer data)
+{
+    SpiceController *fake_this = (SpiceController *)data;
+
+    fake_this->SetupClientProcess();
+}
+
+// reports a client that has not been started, because it failed or its
+// launch was cancelled; code is the SPICEC error code reported as its
+// exit status
+void SpiceController::ReportNotStarted(LaunchResult result, int code)
+{
+    SetState(STATE_EXITED);
+    g_mutex_lock(&m_lock);
+    m_stop_time = 0;
+    if (m_plugin != NULL) {
+        m_plugin->OnSpiceClientReady(result);
+        m_plugin->OnSpiceClientExit(code);
+    }
+    g_mutex_unlock(&m_lock);
 }
 
 gpointer SpiceController::ClientThread(gpointer data)
 {
     SpiceController *fake_this = (SpiceController *)data;
-    gchar **env = g_get_environ();
+    gchar **env;
     GPid pid;
     gboolean spawned = FALSE;
     GError *error = NULL;
     GStrv client_argv;
+    GCancellable *cancellable;
+    gint64 deadline;
+    bool reachable;
+    bool cancelled = false;
+    bool detached;
+    const bool capture = !fake_this->m_log.empty();
+    int out_fd, err_fd;
+    int rc;
+
+    g_mutex_lock(&fake_this->m_lock);
+    cancellable = G_CANCELLABLE(g_object_ref(fake_this->m_cancellable));
+    deadline = fake_this->m_connect_deadline;
+    g_mutex_unlock(&fake_this->m_lock);
+    fake_this->m_client_context = g_main_context_new();
+
+    fake_this->StartProbe(cancellable);
+    if (!fake_this->AcquireLaunchSlot(cancellable, deadline)) {
+        fake_this->FinishProbe(cancellable);
+        if (g_cancellable_is_cancelled(cancellable)) {
+            g_debug("client launch cancelled");
+            fake_this->ReportNotStarted(LAUNCH_CANCELLED, SPICEC_ERROR_CODE_SUCCESS);
+        } else {
+            g_warning("timed out waiting to start the client");
+            fake_this->ReportNotStarted(LAUNCH_FAILED, SPICEC_ERROR_CODE_AGENT_TIMEOUT);
+        }
+        goto done;
+    }
+
+    if (g_cancellable_is_cancelled(cancellable)) {
+        g_debug("client launch cancelled");
+        fake_this->FinishProbe(cancellable);
+        fake_this->ReleaseLaunchSlot();
+        fake_this->ReportNotStarted(LAUNCH_CANCELLED, SPICEC_ERROR_CODE_SUCCESS);
+        goto done;
+    }
+
+    // don't bother spawning a client for a server known to be unreachable
+    if (fake_this->ProbeFailed()) {
+        fake_this->FinishProbe(cancellable);
+        fake_this->ReleaseLaunchSlot();
+        g_warning("server %s is unreachable, not starting the client",
+                  fake_this->m_probe_host.c_str());
+        fake_this->ReportNotStarted(LAUNCH_FAILED, SPICEC_ERROR_CODE_CONNECT_FAILED);
+        goto done;
+    }
 
     // Setup client environment
+    env = g_get_environ();
     fake_this->SetupControllerPipe(env);
     if (!fake_this->m_proxy.empty())
         env = g_environ_setenv(env, "SPICE_PROXY", fake_this->m_proxy.c_str(), TRUE);
@@ -175,11 +847,14 @@ gpointer SpiceController::ClientThread(gpointer data)
         g_warning("main client cmdline: %s", argv_str);
         g_free(argv_str);
 
-        spawned = g_spawn_async(NULL,
-                                client_argv, env,
-                                G_SPAWN_DO_NOT_REAP_CHILD,
-                                NULL, NULL, /* child_func, child_arg */
-                                &pid, &error);
+        spawned = g_spawn_async_with_pipes(NULL,
+                                           client_argv, env,
+                                           G_SPAWN_DO_NOT_REAP_CHILD,
+                                           ClientSetup, fake_this,
+                                           &pid, NULL,
+                                           capture ? &out_fd : NULL,
+                                           capture ? &err_fd : NULL,
+                                           &error);
         if (error != NULL) {
             g_warning("failed to start %s: %s", client_argv[0], error->message);
             g_warn_if_fail(spawned == FALSE);
@@ -202,10 +877,13 @@ gpointer SpiceController::ClientThread(gpointer data)
         g_free(argv_str);
 
         g_message("failed to run preferred client, running fallback client instead");
-        spawned = g_spawn_async(NULL, fallback_argv, env,
-                                G_SPAWN_DO_NOT_REAP_CHILD,
-                                NULL, NULL, /* child_func, child_arg */
-                                &pid, &error);
+        spawned = g_spawn_async_with_pipes(NULL, fallback_argv, env,
+                                           G_SPAWN_DO_NOT_REAP_CHILD,
+                                           ClientSetup, fake_this,
+                                           &pid, NULL,
+                                           capture ? &out_fd : NULL,
+                                           capture ? &err_fd : NULL,
+                                           &error);
         if (error != NULL) {
             g_warning("failed to start %s: %s", fallback_argv[0], error->message);
             g_warn_if_fail(spawned == FALSE);
@@ -218,24 +896,138 @@ gpointer SpiceController::ClientThread(gpointer data)
 
     if (!spawned) {
         g_critical("ERROR failed to run spicec fallback");
-        return NULL;
+        fake_this->FinishProbe(cancellable);
+        fake_this->ReleaseLaunchSlot();
+        fake_this->ReportNotStarted(LAUNCH_FAILED, SPICEC_ERROR_CODE_ERROR);
+        goto done;
     }
 
-#ifdef XP_UNIX
+    if (capture)
+        fake_this->WatchClientOutput(out_fd, err_fd);
+
+    fake_this->SetState(STATE_SPAWNING, STATE_WAITING_SOCKET);
+    g_mutex_lock(&fake_this->m_lock);
     fake_this->m_pid_controller = pid;
-#endif
+    // StopClient() may have been called while the client was spawning
+    if (fake_this->m_stop_time != 0)
+        fake_this->TerminateClient();
+    g_mutex_unlock(&fake_this->m_lock);
+
+    reachable = fake_this->FinishProbe(cancellable);
+    if (g_cancellable_is_cancelled(cancellable)) {
+        // StopClient() has already asked the client to exit
+        rc = -1;
+        cancelled = true;
+    } else if (!reachable) {
+        // reported as a connection failure once the client has exited
+        g_warning("server %s is unreachable, stopping the client",
+                  fake_this->m_probe_host.c_str());
+        fake_this->m_failure_code = SPICEC_ERROR_CODE_CONNECT_FAILED;
+        fake_this->StopClient();
+        rc = -1;
+    } else {
+        // wait for the controller socket here, so that neither the browser's
+        // main thread nor the other clients being launched are blocked by it
+        rc = fake_this->Connect(cancellable, deadline);
+        if (rc != 0 && g_cancellable_is_cancelled(cancellable)) {
+            cancelled = true;
+        } else if (rc != 0) {
+            if (g_get_monotonic_time() >= deadline)
+                fake_this->m_failure_code = SPICEC_ERROR_CODE_AGENT_TIMEOUT;
+            fake_this->StopClient();
+        }
+    }
+    // StopClient() may have been called just after the socket got connected
+    if (rc == 0 && g_cancellable_is_cancelled(cancellable)) {
+        rc = -1;
+        cancelled = true;
+    }
+    if (rc == 0 && fake_this->SetState(STATE_WAITING_SOCKET, STATE_HANDSHAKING) &&
+        !fake_this->m_handshake.empty()) {
+        const uint32_t size = fake_this->m_handshake.size();
+        if (fake_this->Write(fake_this->m_handshake.data(), size) != size) {
+            g_critical("failed to send the handshake to the client");
+            fake_this->StopClient();
+            rc = -1;
+        }
+    }
+    if (rc == 0 && !fake_this->SetState(STATE_HANDSHAKING, STATE_CONNECTED)) {
+        rc = -1;
+        cancelled = true;
+    }
+    fake_this->ReleaseLaunchSlot();
+
+    g_mutex_lock(&fake_this->m_lock);
+    if (fake_this->m_plugin != NULL)
+        fake_this->m_plugin->OnSpiceClientReady(rc == 0 ? LAUNCH_CONNECTED :
+                                                cancelled ? LAUNCH_CANCELLED :
+                                                LAUNCH_FAILED);
+    g_mutex_unlock(&fake_this->m_lock);
+
     fake_this->WaitForPid(pid);
 
+done:
+    g_object_unref(cancellable);
+    g_main_context_unref(fake_this->m_client_context);
+    fake_this->m_client_context = NULL;
+
+    g_mutex_lock(&fake_this->m_lock);
+    fake_this->m_thread_done = true;
+    detached = fake_this->m_detached;
+    g_mutex_unlock(&fake_this->m_lock);
+
+    // the plugin instance is gone, see Shutdown()
+    if (detached)
+        DeleteDetached(fake_this);
+
     return NULL;
 }
 
+// Starts a new client, unless one is already being started or running.
+// The thread of a client which has exited is joined first, it has nothing
+// left to do but to clean up.
 bool SpiceController::StartClient()
 {
-    GThread *thread;
+    if (!IsClientIdle()) {
+        g_warning("client is %s, not starting another one",
+                  GetStateName(GetState()));
+        return false;
+    }
+
+    if (m_client_thread != NULL) {
+        g_thread_join(m_client_thread);
+        m_client_thread = NULL;
+    }
+    // the exit of the previous client may not have been handled yet, its
+    // socket must not be taken for the new client's one
+    Disconnect();
+    ++m_attempt;
+
+    // forget a stop request made while no client was running, and start
+    // the clock for the new attempt
+    g_mutex_lock(&m_lock);
+    m_stop_time = 0;
+    m_thread_done = false;
+    if (m_cancellable != NULL)
+        g_object_unref(m_cancellable);
+    m_cancellable = g_cancellable_new();
+    m_connect_deadline = g_get_monotonic_time() +
+                         m_connect_timeout * G_GINT64_CONSTANT(1000);
+    g_mutex_unlock(&m_lock);
+    m_failure_code = 0;
+
+    g_mutex_lock(&m_log_lock);
+    m_log_start = 0;
+    m_log_len = 0;
+    g_mutex_unlock(&m_log_lock);
+
+    m_state_epoch = g_get_monotonic_time();
+    g_atomic_int_set(&m_state_history_len, 0);
+    SetState(STATE_SPAWNING);
 
-    thread = g_thread_new("spice-xpi client thread", ClientThread, this);
+    m_client_thread = g_thread_new("spice-xpi client thread", ClientThread, this);
 
-    return (thread != NULL);
+    return (m_client_thread != NULL);
 }
 
 int SpiceController::TranslateRC(int nRC)
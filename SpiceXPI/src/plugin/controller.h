@@ -61,6 +61,7 @@
 #include <glib-object.h> /* for GStrv */
 #include <gio/gio.h>
 #include <string>
+#include <vector>
 extern "C" {
 #  include <stdint.h>
 #  include <limits.h>
@@ -70,18 +71,57 @@ extern "C" {
 
 class nsPluginInstance;
 
+// number of state transitions kept for diagnostics
+#define STATE_HISTORY_SIZE 16
+
 class SpiceController
 {
 public:
+    enum State {
+        STATE_IDLE,
+        STATE_SPAWNING,
+        STATE_WAITING_SOCKET,
+        STATE_HANDSHAKING,
+        STATE_CONNECTED,
+        STATE_EXITING,
+        STATE_EXITED
+    };
+
+    // outcome of a client launch, as passed to the plugin instance
+    enum LaunchResult {
+        LAUNCH_CONNECTED,
+        LAUNCH_FAILED,
+        LAUNCH_CANCELLED
+    };
+
     SpiceController(nsPluginInstance *aPlugin);
     virtual ~SpiceController();
 
     bool StartClient();
-    virtual void StopClient() = 0;
+    void StopClient();
+    void Shutdown();
+    static void WaitForDetached();
     void SetFilename(const std::string &name);
     void SetProxy(const std::string &proxy);
-    int Connect(int nRetries);
+    void SetHandshake(const std::string &handshake);
+    void SetProbe(const std::string &host, int port, int sport);
+    void SetConnectTimeout(guint timeout);
+    int Connect(GCancellable *cancellable, gint64 deadline);
+    bool IterateClientContext(GCancellable *cancellable, guint timeout);
     virtual void Disconnect();
+    bool IsClientRunning() const { return m_pid_controller != 0; }
+    bool IsClientIdle() const
+    {
+        const State state = GetState();
+        return state == STATE_IDLE || state == STATE_EXITED;
+    }
+    State GetState() const { return (State)g_atomic_int_get(&m_state); }
+    // counts the StartClient() calls, tells the notifications of the
+    // current client from those of a previous one
+    unsigned int GetAttempt() const { return m_attempt; }
+    std::string GetStateHistory() const;
+    std::string GetClientLog() const;
+    static const char *GetStateName(State state);
     virtual uint32_t Write(const void *lpBuffer, uint32_t nBytesToWrite) = 0;
 
     static int TranslateRC(int nRC);
@@ -89,22 +129,116 @@ public:
 protected:
     std::string m_name;
     std::string m_proxy;
+    std::string m_handshake;
     GPid m_pid_controller;
     GOutputStream *m_pipe;
 
 private:
     virtual int Connect() = 0;
+    virtual void TerminateClient() = 0;
+    virtual void KillClient() = 0;
     void WaitForPid(GPid pid);
+    void ArmShutdownTimeout();
+    static gboolean ShutdownTimeout(gpointer user_data);
     virtual void SetupControllerPipe(GStrv &env) = 0;
     virtual bool CheckPipe() = 0;
     virtual GStrv GetClientPath(void) = 0;
     virtual GStrv GetFallbackClientPath(void) = 0;
+    virtual void SetupClientProcess() = 0;
+    static void ClientSetup(gpointer data);
     static void ChildExited(GPid pid, gint status, gpointer user_data);
     static gpointer ClientThread(gpointer data);
 
+    void WatchClientOutput(int out_fd, int err_fd);
+    bool DrainClientOutput(GIOChannel *channel);
+    void AppendClientLog(const char *data, size_t size);
+    void DumpClientLog();
+    static gboolean ClientOutput(GIOChannel *channel, GIOCondition condition, gpointer user_data);
+
+    void StartProbe(GCancellable *cancellable);
+    bool ProbeFailed();
+    bool FinishProbe(GCancellable *cancellable);
+    static void ProbeConnected(GObject *source, GAsyncResult *result, gpointer user_data);
+    static gboolean ProbeTimeout(gpointer user_data);
+
     nsPluginInstance *m_plugin;
 
+    GThread *m_client_thread;
     GMainLoop *m_child_watch_mainloop;
+    // private context of the client thread, it reads the client's output
+    // and drives the probe from the spawn until the client has exited
+    GMainContext *m_client_context;
+
+    // set by Shutdown() and by the client thread as it finishes; whichever
+    // comes last deletes the controller
+    bool m_detached;
+    bool m_thread_done;
+
+    // protects m_plugin, m_pid_controller, m_child_watch_mainloop,
+    // m_stop_time, m_cancellable, m_detached and m_thread_done, which are
+    // shared with the client thread
+    GMutex m_lock;
+    gint64 m_stop_time;
+    guint m_shutdown_timeout;
+
+    // server reachability probe, run by the client thread while the
+    // client is being spawned
+    std::string m_probe_host;
+    int m_probe_port;
+    int m_probe_sport;
+    guint m_probe_timeout;
+    GMainContext *m_probe_context;
+    GCancellable *m_probe_cancellable;
+    GSource *m_probe_timeout_source;
+    int m_probe_pending;
+    bool m_probe_reachable;
+    gulong m_probe_cancelled_id;
+
+    // time allowed for the client to be started and connected, and the
+    // resulting deadline of the current attempt
+    guint m_connect_timeout;
+    gint64 m_connect_deadline;
+    // cancelled by StopClient(), aborts the client startup
+    GCancellable *m_cancellable;
+    // reported instead of the client's exit status, when non-zero
+    int m_failure_code;
+    // only changed by StartClient(), while there is no client thread
+    unsigned int m_attempt;
+
+    // the connection state may be read from any thread without locking;
+    // every transition is appended to m_state_history, each entry holding
+    // the state in its low 3 bits and the time since StartClient() in ms
+    gint m_state;
+    gint64 m_state_epoch;
+    gint m_state_history[STATE_HISTORY_SIZE];
+    gint m_state_history_len;
+
+    // the last output of the client, both stdout and stderr, kept in a
+    // ring buffer of SPICE_XPI_CLIENT_LOG_SIZE bytes; the pipes are read
+    // by the client thread, m_log_lock protects the buffer
+    mutable GMutex m_log_lock;
+    std::vector<char> m_log;
+    size_t m_log_start;
+    size_t m_log_len;
+    GIOChannel *m_log_channels[2];
+
+    void ReportNotStarted(LaunchResult result, int code);
+    void SetState(State state);
+    bool SetState(State from, State to);
+    void RecordState(State state);
+    static bool AcquireLaunchSlot(GCancellable *cancellable, gint64 deadline);
+    static void ReleaseLaunchSlot();
+    static GMutex s_launch_lock;
+    static GCond s_launch_cond;
+    static int s_launches;
+
+    // controllers deleted by their client threads, see Shutdown()
+    static void DeleteDetached(SpiceController *controller);
+    static GMutex s_detached_lock;
+    static GCond s_detached_cond;
+    static int s_detached;
+    static gint64 s_detached_deadline;
+    static int s_max_launches;
 };
 
 #endif // SPICE_CONTROLLER_H
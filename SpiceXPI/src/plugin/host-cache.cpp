@@ -0,0 +1,179 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ *   Version: MPL 1.1/GPL 2.0/LGPL 2.1
+ *
+ *   The contents of this file are subject to the Mozilla Public License Version
+ *   1.1 (the "License"); you may not use this file except in compliance with
+ *   the License. You may obtain a copy of the License at
+ *   http://www.mozilla.org/MPL/
+ *
+ *   Software distributed under the License is distributed on an "AS IS" basis,
+ *   WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+ *   for the specific language governing rights and limitations under the
+ *   License.
+ *
+ *   Copyright 2026, Red Hat Inc.
+ *
+ *   Alternatively, the contents of this file may be used under the terms of
+ *   either the GNU General Public License Version 2 or later (the "GPL"), or
+ *   the GNU Lesser General Public License Version 2.1 or later (the "LGPL"),
+ *   in which case the provisions of the GPL or the LGPL are applicable instead
+ *   of those above. If you wish to allow use of your version of this file only
+ *   under the terms of either the GPL or the LGPL, and not to allow others to
+ *   use your version of this file under the terms of the MPL, indicate your
+ *   decision by deleting the provisions above and replace them with the notice
+ *   and other provisions required by the GPL or the LGPL. If you do not delete
+ *   the provisions above, a recipient may use your version of this file under
+ *   the terms of any one of the MPL, the GPL or the LGPL.
+ *
+ * ***** END LICENSE BLOCK ***** */
+
+#include "config.h"
+
+#include <cstdlib>
+#include <map>
+#include <glib.h>
+#include <gio/gio.h>
+
+#include "host-cache.h"
+
+struct HostCacheEntry {
+    bool pending;
+    std::string address; // empty for a name with several addresses
+    gint64 expires;
+};
+
+// time host_lookup_cancel() waits for the cancelled lookups to complete
+#define HOST_LOOKUP_CANCEL_TIMEOUT 1000 // ms
+
+static std::map<std::string, HostCacheEntry> s_host_cache;
+static GCancellable *s_host_lookup_cancellable = NULL;
+// the lookups in progress and the context their callbacks are run in
+static int s_host_lookups = 0;
+static GMainContext *s_host_lookup_context = NULL;
+
+static gint64 host_cache_ttl(void)
+{
+    static gint64 ttl = -1;
+
+    if (ttl < 0) {
+        const char *env = g_getenv("SPICE_XPI_DNS_CACHE_TTL");
+        ttl = env ? strtol(env, NULL, 10) : 0;
+        if (ttl < 0)
+            ttl = 0;
+    }
+
+    return ttl * G_USEC_PER_SEC;
+}
+
+static void host_lookup_finished(GObject *source, GAsyncResult *result,
+                                 gpointer user_data)
+{
+    gchar *host = (gchar *)user_data;
+    GError *error = NULL;
+    GList *addresses;
+
+    addresses = g_resolver_lookup_by_name_finish(G_RESOLVER(source), result, &error);
+    if (addresses == NULL) {
+        g_debug("failed to resolve %s: %s", host, error->message);
+        g_clear_error(&error);
+        s_host_cache.erase(host);
+    } else {
+        HostCacheEntry &entry = s_host_cache[host];
+        entry.pending = false;
+        entry.expires = g_get_monotonic_time() + host_cache_ttl();
+        if (addresses->next == NULL) {
+            gchar *address = g_inet_address_to_string(G_INET_ADDRESS(addresses->data));
+            entry.address = address;
+            g_debug("%s resolved to %s", host, address);
+            g_free(address);
+        } else {
+            entry.address.clear();
+            g_debug("%s has %u addresses, the client will resolve it",
+                    host, g_list_length(addresses));
+        }
+        g_resolver_free_addresses(addresses);
+    }
+    g_free(host);
+    --s_host_lookups;
+}
+
+void host_lookup_start(const std::string &host)
+{
+#if defined(XP_UNIX)
+    if (host.empty() || g_hostname_is_ip_address(host.c_str()) ||
+        host_cache_ttl() == 0)
+        return;
+
+    std::map<std::string, HostCacheEntry>::iterator it = s_host_cache.find(host);
+    if (it != s_host_cache.end() &&
+        (it->second.pending || it->second.expires > g_get_monotonic_time()))
+        return; // pending or still valid
+
+    HostCacheEntry &entry = s_host_cache[host];
+    entry.pending = true;
+    entry.address.clear();
+    entry.expires = 0;
+
+    if (s_host_lookup_cancellable == NULL) {
+        s_host_lookup_cancellable = g_cancellable_new();
+        s_host_lookup_context = g_main_context_ref_thread_default();
+    }
+
+    GResolver *resolver = g_resolver_get_default();
+    g_resolver_lookup_by_name_async(resolver, host.c_str(), s_host_lookup_cancellable,
+                                    host_lookup_finished, g_strdup(host.c_str()));
+    ++s_host_lookups;
+    g_object_unref(resolver);
+#endif
+}
+
+std::string host_lookup_cached(const std::string &host)
+{
+    std::map<std::string, HostCacheEntry>::const_iterator it = s_host_cache.find(host);
+    if (it == s_host_cache.end() || it->second.pending ||
+        it->second.address.empty() ||
+        it->second.expires <= g_get_monotonic_time())
+        return host;
+
+    return it->second.address;
+}
+
+bool host_lookup_pending(const std::string &host)
+{
+    std::map<std::string, HostCacheEntry>::const_iterator it = s_host_cache.find(host);
+    return it != s_host_cache.end() && it->second.pending;
+}
+
+static gboolean host_lookup_cancel_timeout(gpointer user_data)
+{
+    *static_cast<bool *>(user_data) = true;
+    return FALSE;
+}
+
+// The cancelled lookups still complete, with an error, and are dropped
+// from the cache. Their callbacks are waited for here, they would run
+// after the plugin has been unloaded otherwise. Called from the thread,
+// which started the lookups, when the plugin is unloaded.
+void host_lookup_cancel(void)
+{
+    if (s_host_lookup_cancellable == NULL)
+        return;
+
+    g_cancellable_cancel(s_host_lookup_cancellable);
+
+    bool timed_out = false;
+    GSource *timeout = g_timeout_source_new(HOST_LOOKUP_CANCEL_TIMEOUT);
+    g_source_set_callback(timeout, host_lookup_cancel_timeout, &timed_out, NULL);
+    g_source_attach(timeout, s_host_lookup_context);
+    while (s_host_lookups > 0 && !timed_out)
+        g_main_context_iteration(s_host_lookup_context, TRUE);
+    g_source_destroy(timeout);
+    g_source_unref(timeout);
+    if (s_host_lookups > 0)
+        g_warning("%d host lookups still in progress", s_host_lookups);
+
+    g_object_unref(s_host_lookup_cancellable);
+    s_host_lookup_cancellable = NULL;
+    g_main_context_unref(s_host_lookup_context);
+    s_host_lookup_context = NULL;
+}
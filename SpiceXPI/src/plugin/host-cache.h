@@ -0,0 +1,56 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ *   Version: MPL 1.1/GPL 2.0/LGPL 2.1
+ *
+ *   The contents of this file are subject to the Mozilla Public License Version
+ *   1.1 (the "License"); you may not use this file except in compliance with
+ *   the License. You may obtain a copy of the License at
+ *   http://www.mozilla.org/MPL/
+ *
+ *   Software distributed under the License is distributed on an "AS IS" basis,
+ *   WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+ *   for the specific language governing rights and limitations under the
+ *   License.
+ *
+ *   Copyright 2026, Red Hat Inc.
+ *
+ *   Alternatively, the contents of this file may be used under the terms of
+ *   either the GNU General Public License Version 2 or later (the "GPL"), or
+ *   the GNU Lesser General Public License Version 2.1 or later (the "LGPL"),
+ *   in which case the provisions of the GPL or the LGPL are applicable instead
+ *   of those above. If you wish to allow use of your version of this file only
+ *   under the terms of either the GPL or the LGPL, and not to allow others to
+ *   use your version of this file under the terms of the MPL, indicate your
+ *   decision by deleting the provisions above and replace them with the notice
+ *   and other provisions required by the GPL or the LGPL. If you do not delete
+ *   the provisions above, a recipient may use your version of this file under
+ *   the terms of any one of the MPL, the GPL or the LGPL.
+ *
+ * ***** END LICENSE BLOCK ***** */
+
+#ifndef HOST_CACHE_H
+#define HOST_CACHE_H
+
+#include <string>
+
+// Host names are resolved in the background as soon as hostIP is set, so
+// that the client can be handed an address instead of resolving the name
+// on the connect path. The results are shared by all the instances and
+// kept for SPICE_XPI_DNS_CACHE_TTL seconds; the cache is disabled unless
+// that is set. The lookups complete on the thread-default main loop of
+// the caller, the browser's main loop in the plugin.
+
+// starts resolving host, unless it is an address or already resolved
+void host_lookup_start(const std::string &host);
+
+// the cached address of host, or host itself when there is none or the
+// name has several addresses, the client then tries them all
+std::string host_lookup_cached(const std::string &host);
+
+// true while a lookup of host is in progress
+bool host_lookup_pending(const std::string &host);
+
+// cancels the lookups in progress and waits for them to complete, called
+// when the plugin is unloaded
+void host_lookup_cancel(void);
+
+#endif // HOST_CACHE_H
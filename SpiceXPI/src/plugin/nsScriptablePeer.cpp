@@ -55,6 +55,8 @@
 
 #include <string.h>
 #include <sstream>
+#include <cerrno>
+#include <cstdlib>
 #include "plugin.h"
 #include "common.h"
 #include "nsScriptablePeer.h"
@@ -85,11 +87,66 @@ NPIdentifier ScriptablePluginObject::m_id_disable_effects;
 NPIdentifier ScriptablePluginObject::m_id_connect;
 NPIdentifier ScriptablePluginObject::m_id_show;
 NPIdentifier ScriptablePluginObject::m_id_disconnect;
+NPIdentifier ScriptablePluginObject::m_id_reconnect;
 NPIdentifier ScriptablePluginObject::m_id_set_language_strings;
 NPIdentifier ScriptablePluginObject::m_id_set_usb_filter;
 NPIdentifier ScriptablePluginObject::m_id_connect_status;
 NPIdentifier ScriptablePluginObject::m_id_plugin_instance;
 NPIdentifier ScriptablePluginObject::m_id_proxy;
+NPIdentifier ScriptablePluginObject::m_id_connect_timeout;
+NPIdentifier ScriptablePluginObject::m_id_client_log;
+
+// ConnectTimeout is given in ms and may be set as a number or as a string
+// of decimal digits; an empty string or NaN (what parseInt() makes of an
+// empty field) keeps the default timeout, like an empty value does for the
+// other attributes; anything else, including a negative or fractional
+// number, is rejected
+static bool variantToTimeout(const NPVariant *value, uint32_t &timeout)
+{
+    if (NPVARIANT_IS_INT32(*value))
+    {
+        const int32_t val = NPVARIANT_TO_INT32(*value);
+        if (val < 0)
+            return false;
+        timeout = val;
+        return true;
+    }
+    else if (NPVARIANT_IS_DOUBLE(*value))
+    {
+        const double val = NPVARIANT_TO_DOUBLE(*value);
+        if (val != val)
+        {
+            timeout = 0;
+            return true;
+        }
+        if (!(val >= 0 && val <= G_MAXUINT32) || val != static_cast<uint32_t>(val))
+            return false;
+        timeout = static_cast<uint32_t>(val);
+        return true;
+    }
+    else if (NPVARIANT_IS_STRING(*value))
+    {
+        const std::string str(NPVARIANT_TO_STRING(*value).UTF8Characters,
+                              NPVARIANT_TO_STRING(*value).UTF8Length);
+        if (str.empty())
+        {
+            timeout = 0;
+            return true;
+        }
+        if (str[0] < '0' || str[0] > '9')
+            return false;
+
+        errno = 0;
+        char *end;
+        const unsigned long val = strtoul(str.c_str(), &end, 10);
+        if (errno || *end != '\0' || val > G_MAXUINT32)
+            return false;
+        timeout = val;
+        return true;
+    }
+
+    return false;
+}
 
 NPObject *AllocateScriptablePluginObject(NPP npp, NPClass *aClass)
 {
@@ -138,11 +195,14 @@ void ScriptablePluginObject::Init()
     m_id_connect = NPN_GetStringIdentifier("connect");
     m_id_show = NPN_GetStringIdentifier("show");
     m_id_disconnect = NPN_GetStringIdentifier("disconnect");
+    m_id_reconnect = NPN_GetStringIdentifier("reconnect");
     m_id_set_language_strings = NPN_GetStringIdentifier("SetLanguageStrings");
     m_id_set_usb_filter = NPN_GetStringIdentifier("SetUsbFilter");
     m_id_connect_status = NPN_GetStringIdentifier("ConnectedStatus");
     m_id_plugin_instance = NPN_GetStringIdentifier("PluginInstance");
     m_id_proxy = NPN_GetStringIdentifier("Proxy");
+    m_id_connect_timeout = NPN_GetStringIdentifier("ConnectTimeout");
+    m_id_client_log = NPN_GetStringIdentifier("ClientLog");
     m_id_set = true;
 }
 
@@ -151,6 +211,7 @@ bool ScriptablePluginObject::HasMethod(NPIdentifier name)
     return(name == m_id_connect ||
            name == m_id_show ||
            name == m_id_disconnect ||
+           name == m_id_reconnect ||
            name == m_id_set_language_strings ||
            name == m_id_set_usb_filter ||
            name == m_id_connect_status);
@@ -180,7 +241,9 @@ bool ScriptablePluginObject::HasProperty(NPIdentifier name)
            name == m_id_usb_auto_share ||
            name == m_id_color_depth ||
            name == m_id_disable_effects ||
-           name == m_id_proxy);
+           name == m_id_proxy ||
+           name == m_id_connect_timeout ||
+           name == m_id_client_log);
 }
 
 bool ScriptablePluginObject::GetProperty(NPIdentifier name, NPVariant *result)
@@ -236,6 +299,10 @@ bool ScriptablePluginObject::GetProperty(NPIdentifier name, NPVariant *result)
         STRINGZ_TO_NPVARIANT(m_plugin->GetDisableEffects(), *result);
     else if (name == m_id_proxy)
         STRINGZ_TO_NPVARIANT(m_plugin->GetProxy(), *result);
+    else if (name == m_id_connect_timeout)
+        DOUBLE_TO_NPVARIANT(m_plugin->GetConnectTimeout(), *result);
+    else if (name == m_id_client_log)
+        STRINGZ_TO_NPVARIANT(m_plugin->GetClientLog(), *result);
     else
         return false;
 
@@ -252,6 +319,15 @@ bool ScriptablePluginObject::SetProperty(NPIdentifier name, const NPVariant *val
     bool boolean = false;
     unsigned short val = -1;
 
+    if (name == m_id_connect_timeout)
+    {
+        uint32_t timeout;
+        if (!variantToTimeout(value, timeout))
+            return false;
+        m_plugin->SetConnectTimeout(timeout);
+        return true;
+    }
+
     if (NPVARIANT_IS_STRING(*value))
     {
         str.assign(NPVARIANT_TO_STRING(*value).UTF8Characters,
@@ -351,6 +427,11 @@ bool ScriptablePluginObject::Invoke(NPIdentifier name, const NPVariant *args,
         m_plugin->Disconnect();
         return true;
     }
+    else if (name == m_id_reconnect)
+    {
+        m_plugin->Reconnect();
+        return true;
+    }
     else if (name == m_id_set_language_strings)
     {
         if(argCount < 2)
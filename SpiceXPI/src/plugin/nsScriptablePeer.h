@@ -101,11 +101,14 @@ private:
     static NPIdentifier m_id_connect;
     static NPIdentifier m_id_show;
     static NPIdentifier m_id_disconnect;
+    static NPIdentifier m_id_reconnect;
     static NPIdentifier m_id_set_language_strings;
     static NPIdentifier m_id_set_usb_filter;
     static NPIdentifier m_id_connect_status;
     static NPIdentifier m_id_plugin_instance;
     static NPIdentifier m_id_proxy;
+    static NPIdentifier m_id_connect_timeout;
+    static NPIdentifier m_id_client_log;
 };
 
 #define DECLARE_NPOBJECT_CLASS_WITH_BASE(_class, ctor)                        \
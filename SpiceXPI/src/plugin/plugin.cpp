@@ -72,6 +72,7 @@ extern "C" {
 #if defined(XP_WIN)
 #include "controller-win.h"
 #endif
+#include "host-cache.h"
 #include "plugin.h"
 #include "nsScriptablePeer.h"
 
@@ -112,17 +113,70 @@ const char *NPP_GetMIMEDescription(void)
     return const_cast<char *>(MIME_TYPES_DESCRIPTION.c_str());
 }
 
+static void glib_log_to_file(const gchar *log_domain,
+                             GLogLevelFlags log_level,
+                             const gchar *message,
+                             gpointer user_data)
+{
+    FILE *log_file;
+
+    if ((log_level & G_LOG_LEVEL_MASK) > G_LOG_LEVEL_MESSAGE) {
+        return;
+    }
+
+    log_file = (FILE *)user_data;
+
+    if (log_domain != NULL) {
+        fwrite(log_domain, strlen(log_domain), 1, log_file);
+        fwrite(": ", 2, 1, log_file);
+    }
+    if (message != NULL) {
+        fwrite(message, strlen(message), 1, log_file);
+    }
+    fwrite("\r\n", 2, 1, log_file);
+    fflush(log_file);
+}
+
+static void glib_setup_logging(void)
+{
+#if defined(XP_WIN)
+    FILE *log_file;
+    gchar *log_filename;
+
+    if (!g_getenv("SPICE_XPI_LOG_TO_FILE"))
+        return;
+
+    log_filename = g_build_filename(g_get_tmp_dir(), "SPICEXPI.LOG", NULL);
+    log_file = fopen(log_filename, "w+");
+    if (log_file != NULL) {
+        g_log_set_default_handler(glib_log_to_file, log_file);
+    } else {
+        gchar *log_msg;
+        log_msg = g_strdup_printf("failed to open %s", log_filename);
+        g_free(log_msg);
+    }
+    g_free(log_filename);
+#endif
+}
+
 //////////////////////////////////////
 //
 // general initialization and shutdown
 //
 NPError NS_PluginInitialize()
 {
+#if !GLIB_CHECK_VERSION(2, 35, 0)
+    g_type_init();
+#endif
+    glib_setup_logging();
+
     return NPERR_NO_ERROR;
 }
 
 void NS_PluginShutdown()
 {
+    host_lookup_cancel();
+    SpiceController::WaitForDetached();
 }
 
 // get values per plugin
@@ -173,55 +227,12 @@ void NS_DestroyPluginInstance(nsPluginInstanceBase *aPlugin)
 //
 // nsPluginInstance class implementation
 //
-static void glib_log_to_file(const gchar *log_domain,
-                             GLogLevelFlags log_level,
-                             const gchar *message,
-                             gpointer user_data)
-{
-    FILE *log_file;
-
-    if ((log_level & G_LOG_LEVEL_MASK) > G_LOG_LEVEL_MESSAGE) {
-        return;
-    }
-
-    log_file = (FILE *)user_data;
-
-    if (log_domain != NULL) {
-        fwrite(log_domain, strlen(log_domain), 1, log_file);
-        fwrite(": ", 2, 1, log_file);
-    }
-    if (message != NULL) {
-        fwrite(message, strlen(message), 1, log_file);
-    }
-    fwrite("\r\n", 2, 1, log_file);
-    fflush(log_file);
-}
-
-static void glib_setup_logging(void)
-{
-#if defined(XP_WIN)
-    FILE *log_file;
-    gchar *log_filename;
-
-    if (!g_getenv("SPICE_XPI_LOG_TO_FILE"))
-        return;
-
-    log_filename = g_build_filename(g_get_tmp_dir(), "SPICEXPI.LOG", NULL);
-    log_file = fopen(log_filename, "w+");
-    if (log_file != NULL) {
-        g_log_set_default_handler(glib_log_to_file, log_file);
-    } else {
-        gchar *log_msg;
-        log_msg = g_strdup_printf("failed to open %s", log_filename);
-        g_free(log_msg);
-    }
-    g_free(log_filename);
-#endif
-}
-
 nsPluginInstance::nsPluginInstance(NPP aInstance):
     nsPluginInstanceBase(),
     m_connected_status(-2),
+    m_connect_start(0),
+    m_external_controller(NULL),
+    m_pipe_batch(false),
     m_instance(aInstance),
     m_initialized(true),
     m_window(NULL),
@@ -231,20 +242,11 @@ nsPluginInstance::nsPluginInstance(NPP aInstance):
     m_no_taskmgr_execution(false),
     m_send_ctrlaltdel(true),
     m_usb_auto_share(true),
+    m_connect_timeout(0),
     m_scriptable_peer(NULL)
 {
-#if !GLIB_CHECK_VERSION(2, 35, 0)
-    g_type_init();
-#endif
-    glib_setup_logging();
-
-#if defined(XP_WIN)
-    m_external_controller = new SpiceControllerWin(this);
-#elif defined(XP_UNIX)
-    m_external_controller = new SpiceControllerUnix(this);
-#else
-#error "Unknown OS, no controller implementation"
-#endif
+    // the controller is created on the first Connect(), many instances
+    // are never connected at all
 }
 
 nsPluginInstance::~nsPluginInstance()
@@ -255,7 +257,11 @@ nsPluginInstance::~nsPluginInstance()
     // and zero its m_plugin member
     if (m_scriptable_peer)
         NPN_ReleaseObject(m_scriptable_peer);
-    delete(m_external_controller);
+    // the controller deletes itself, once its client has exited
+    if (m_external_controller)
+        m_external_controller->Shutdown();
+    // the client exit notification is suppressed on shutdown
+    RemoveTrustStoreFile();
 }
 
 NPBool nsPluginInstance::init(NPWindow *aWindow)
@@ -281,7 +287,9 @@ NPBool nsPluginInstance::init(NPWindow *aWindow)
     m_color_depth.clear();
     m_disable_effects.clear();
     m_proxy.clear();
-    m_external_controller->SetProxy(std::string());
+    if (m_external_controller)
+        m_external_controller->SetProxy(std::string());
+    m_connect_timeout = 0;
 
     m_fullscreen = false;
     m_smartcard = false;
@@ -318,6 +326,7 @@ char *nsPluginInstance::GetHostIP() const
 void nsPluginInstance::SetHostIP(const char *aHostIP)
 {
     m_host_ip = aHostIP;
+    host_lookup_start(m_host_ip);
 }
 
 /* attribute string port; */
@@ -427,6 +436,8 @@ bool nsPluginInstance::GetFullScreen() const
 void nsPluginInstance::SetFullScreen(bool aFullScreen)
 {
     m_fullscreen = aFullScreen;
+    if (IsClientConnected())
+        UpdateField(ControllerHandshake::FIELD_fullScreen, GetFullScreenFlags());
 }
 
 /* attribute boolean Smartcard; */
@@ -449,6 +460,8 @@ char *nsPluginInstance::GetTitle() const
 void nsPluginInstance::SetTitle(const char *aTitle)
 {
     m_title = aTitle;
+    if (IsClientConnected())
+        UpdateField(ControllerHandshake::FIELD_Title, m_title);
 }
 
 /* attribute string dynamicMenu; */
@@ -504,6 +517,8 @@ char *nsPluginInstance::GetHotKeys() const
 void nsPluginInstance::SetHotKeys(const char *aHotKeys)
 {
     m_hot_keys = aHotKeys;
+    if (IsClientConnected())
+        UpdateField(ControllerHandshake::FIELD_HotKey, m_hot_keys);
 }
 
 /* attribute boolean NoTaskMgrExecution; */
@@ -553,6 +568,8 @@ bool nsPluginInstance::GetUsbAutoShare() const
 void nsPluginInstance::SetUsbAutoShare(bool aUsbAutoShare)
 {
     m_usb_auto_share = aUsbAutoShare;
+    if (IsClientConnected())
+        UpdateField(ControllerHandshake::FIELD_UsbAutoShare, m_usb_auto_share);
 }
 
 /* attribute string ColorDepth; */
@@ -575,6 +592,8 @@ char *nsPluginInstance::GetDisableEffects() const
 void nsPluginInstance::SetDisableEffects(const char *aDisableEffects)
 {
     m_disable_effects = aDisableEffects;
+    if (IsClientConnected())
+        UpdateField(ControllerHandshake::FIELD_DisableEffects, m_disable_effects);
 }
 
 /* attribute string Proxy; */
@@ -586,12 +605,63 @@ char *nsPluginInstance::GetProxy() const
 void nsPluginInstance::SetProxy(const char *aProxy)
 {
     m_proxy = aProxy;
-    m_external_controller->SetProxy(m_proxy);
+    if (m_external_controller)
+        m_external_controller->SetProxy(m_proxy);
+}
+
+/* attribute unsigned long ConnectTimeout; */
+// time allowed for the client to start and connect, in ms, 0 for the
+// default; a disconnect() before then aborts the attempt
+uint32_t nsPluginInstance::GetConnectTimeout() const
+{
+    return m_connect_timeout;
+}
+
+void nsPluginInstance::SetConnectTimeout(uint32_t aConnectTimeout)
+{
+    m_connect_timeout = aConnectTimeout;
+}
+
+/* readonly attribute string ClientLog; */
+char *nsPluginInstance::GetClientLog() const
+{
+    if (!m_external_controller)
+        return stringCopy(std::string());
+
+    return stringCopy(m_external_controller->GetClientLog());
+}
+
+// Outgoing messages are collected in m_pipe_buffer, which keeps its
+// capacity between messages. They are written right away, unless a batch
+// is in progress; the whole handshake goes out in a single write.
+void nsPluginInstance::QueueToPipe(const void *data, uint32_t size)
+{
+    m_pipe_buffer.append(static_cast<const char *>(data), size);
 }
 
 void nsPluginInstance::WriteToPipe(const void *data, uint32_t size)
 {
-    m_external_controller->Write(data, size);
+    QueueToPipe(data, size);
+    if (!m_pipe_batch)
+        FlushPipe();
+}
+
+void nsPluginInstance::FlushPipe()
+{
+    if (m_external_controller && !m_pipe_buffer.empty())
+        m_external_controller->Write(m_pipe_buffer.data(), m_pipe_buffer.size());
+    m_pipe_buffer.clear();
+}
+
+void nsPluginInstance::BeginPipeBatch()
+{
+    m_pipe_batch = true;
+}
+
+void nsPluginInstance::EndPipeBatch()
+{
+    m_pipe_batch = false;
+    FlushPipe();
 }
 
 void nsPluginInstance::SendInit()
@@ -622,18 +692,95 @@ void nsPluginInstance::SendBool(uint32_t id, bool value)
     WriteToPipe(&msg, sizeof(msg));
 }
 
-void nsPluginInstance::SendStr(uint32_t id, std::string str)
+void nsPluginInstance::SendStr(uint32_t id, const std::string &str)
 {
     if (str.empty())
         return;
 
-    size_t size = sizeof(ControllerData) + str.size() + 1;
-    ControllerData *msg = static_cast<ControllerData *>(malloc(size));
-    msg->base.id = id;
-    msg->base.size = size;
-    strcpy(reinterpret_cast<char *>(msg->data), str.c_str());
-    WriteToPipe(msg, size);
-    free(msg);
+    ControllerMsg msg = { id, static_cast<uint32_t>(sizeof(ControllerData) + str.size() + 1) };
+    QueueToPipe(&msg, sizeof(msg));
+    WriteToPipe(str.c_str(), str.size() + 1);
+}
+
+// The attributes annotated in nsISpicec.idl are sent with the message and
+// the encoding given there, see controller-handshake.h. Like in the
+// handshake, an empty string and a zero value are not sent.
+void nsPluginInstance::SendField(ControllerHandshake::Index field, const std::string &str)
+{
+    const ControllerHandshake::Field &f = ControllerHandshake::Fields()[field];
+
+    g_return_if_fail(f.encoding == ControllerHandshake::ENCODING_STR);
+    SendStr(f.message, str);
+}
+
+void nsPluginInstance::SendField(ControllerHandshake::Index field, uint32_t value)
+{
+    const ControllerHandshake::Field &f = ControllerHandshake::Fields()[field];
+
+    g_return_if_fail(f.encoding != ControllerHandshake::ENCODING_STR);
+    if (f.encoding == ControllerHandshake::ENCODING_BOOL)
+        SendBool(f.message, value);
+    else
+        SendValue(f.message, value);
+}
+
+// unlike SendField(), this also sends an empty string and a zero value, so
+// that a running client can have a value cleared or be switched back from
+// full screen
+void nsPluginInstance::UpdateField(ControllerHandshake::Index field, const std::string &str)
+{
+    const ControllerHandshake::Field &f = ControllerHandshake::Fields()[field];
+
+    g_return_if_fail(f.encoding == ControllerHandshake::ENCODING_STR);
+    ControllerMsg msg = { f.message, static_cast<uint32_t>(sizeof(ControllerData) + str.size() + 1) };
+    QueueToPipe(&msg, sizeof(msg));
+    WriteToPipe(str.c_str(), str.size() + 1);
+}
+
+void nsPluginInstance::UpdateField(ControllerHandshake::Index field, uint32_t value)
+{
+    const ControllerHandshake::Field &f = ControllerHandshake::Fields()[field];
+
+    g_return_if_fail(f.encoding != ControllerHandshake::ENCODING_STR);
+    ControllerValue msg = { {f.message, sizeof(msg)}, value };
+    WriteToPipe(&msg, sizeof(msg));
+}
+
+uint32_t nsPluginInstance::GetFullScreenFlags() const
+{
+    return (m_fullscreen == true ? CONTROLLER_SET_FULL_SCREEN : 0) |
+           (m_admin_console == false ? CONTROLLER_AUTO_DISPLAY_RES : 0);
+}
+
+// The client is given the pre-resolved address of the host, unless it
+// needs the name itself: to reach the host through a proxy, or to check
+// the server certificate when no host subject is set.
+std::string nsPluginInstance::GetConnectHost(int sport) const
+{
+    if (!m_proxy.empty() || (sport > 0 && m_host_subject.empty()))
+        return m_host_ip;
+
+    return host_lookup_cached(m_host_ip);
+}
+
+void nsPluginInstance::SendConnectionParams(int port, int sport)
+{
+    SendField(ControllerHandshake::FIELD_hostIP, GetConnectHost(sport));
+    SendField(ControllerHandshake::FIELD_port, port > 0 ? port : 0);
+    SendField(ControllerHandshake::FIELD_SecurePort, sport > 0 ? sport : 0);
+    SendField(ControllerHandshake::FIELD_Password, m_password);
+}
+
+void nsPluginInstance::CreateController()
+{
+#if defined(XP_WIN)
+    m_external_controller = new SpiceControllerWin(this);
+#elif defined(XP_UNIX)
+    m_external_controller = new SpiceControllerUnix(this);
+#else
+#error "Unknown OS, no controller implementation"
+#endif
+    m_external_controller->SetProxy(m_proxy);
 }
 
 bool nsPluginInstance::CreateTrustStoreFile(const std::string &trust_store)
@@ -641,6 +788,15 @@ bool nsPluginInstance::CreateTrustStoreFile(const std::string &trust_store)
     GFile *tmp_file;
     GFileIOStream *iostream;
     GOutputStream *stream;
+    gchar *path;
+
+    // a file left over from a previous connection attempt is stale
+    RemoveTrustStoreFile();
+
+    // without a trust store there is nothing to write, and the
+    // CA file message is not sent at all
+    if (trust_store.empty())
+        return true;
 
     tmp_file = g_file_new_tmp("trustore.pem-XXXXXX", &iostream, NULL);
     if (tmp_file == NULL) {
@@ -648,15 +804,21 @@ bool nsPluginInstance::CreateTrustStoreFile(const std::string &trust_store)
         return false;
     }
 
+    path = g_file_get_path(tmp_file);
     stream = g_io_stream_get_output_stream(G_IO_STREAM(iostream));
     if (!g_output_stream_write_all(stream,
                                    trust_store.c_str(),
                                    trust_store.length(),
                                    NULL, NULL, NULL)) {
         g_critical("Couldn't write truststore");
+        g_unlink(path);
+        g_free(path);
+        g_object_unref(tmp_file);
+        g_object_unref(iostream);
         return false;
     }
-    m_trust_store_file = g_file_get_path(tmp_file);
+    m_trust_store_file = path;
+    g_free(path);
     g_object_unref(tmp_file);
     g_object_unref(iostream);
 
@@ -665,8 +827,11 @@ bool nsPluginInstance::CreateTrustStoreFile(const std::string &trust_store)
 
 bool nsPluginInstance::RemoveTrustStoreFile()
 {
+    if (m_trust_store_file.empty())
+        return true;
+
     if (g_unlink(m_trust_store_file.c_str()) != 0)
-        return false;;
+        return false;
 
     m_trust_store_file.clear();
 
@@ -675,6 +840,14 @@ bool nsPluginInstance::RemoveTrustStoreFile()
 
 void nsPluginInstance::Connect()
 {
+    // only one client per instance, a running one is reused by Reconnect()
+    if (m_external_controller && !m_external_controller->IsClientIdle())
+    {
+        g_warning("client is already %s, ignoring connect()",
+                  SpiceController::GetStateName(m_external_controller->GetState()));
+        return;
+    }
+
     const int port = portToInt(m_port);
     const int sport = portToInt(m_secure_port);
     if (port < 0)
@@ -683,70 +856,175 @@ void nsPluginInstance::Connect()
         g_warning("invalid secure port: '%s'", m_secure_port.c_str());
     if (port <= 0 && sport <= 0)
     {
-        m_connected_status = 1;
-        CallOnDisconnected(m_connected_status);
+        g_atomic_int_set(&m_connected_status, 1);
+        CallOnDisconnected(1);
         return;
     }
 
+    m_connect_start = g_get_monotonic_time();
+    if (!m_external_controller)
+        CreateController();
+    m_external_controller->SetProbe(host_lookup_cached(m_host_ip), port, sport);
+    m_external_controller->SetConnectTimeout(m_connect_timeout);
+
+    if (!this->CreateTrustStoreFile(m_trust_store)) {
+        g_critical("failed to create trust store");
+        return;
+    }
+
+    // the attributes annotated in nsISpicec.idl go through the generated
+    // serializer, see controller-handshake.h
+    const std::string host = GetConnectHost(sport);
+    ControllerHandshake handshake;
+    handshake.hostIP = &host;
+    handshake.port = port > 0 ? port : 0;
+    handshake.SecurePort = sport > 0 ? sport : 0;
+    handshake.Password = &m_password;
+    handshake.CipherSuite = &m_cipher_suite;
+    handshake.SSLChannels = &m_ssl_channels;
+    handshake.HostSubject = &m_host_subject;
+    handshake.fullScreen = GetFullScreenFlags();
+    handshake.Title = &m_title;
+    handshake.HotKey = &m_hot_keys;
+    handshake.SendCtrlAltDelete = m_send_ctrlaltdel;
+    handshake.UsbAutoShare = m_usb_auto_share;
+    handshake.Smartcard = m_smartcard;
+    handshake.ColorDepth = atoi(m_color_depth.c_str());
+    handshake.DisableEffects = &m_disable_effects;
+
+    // the handshake is serialized up front, the client thread sends it as
+    // soon as the controller socket is connected, without a round trip
+    // through the main thread
+    BeginPipeBatch();
+    SendInit();
+    handshake.AppendTo(m_pipe_buffer);
+    // TrustStore holds the certificates, the client gets the file
+    SendStr(CONTROLLER_CA_FILE, m_trust_store_file);
+    SendStr(CONTROLLER_USB_FILTER, m_usb_filter);
+    SendMsg(CONTROLLER_CONNECT);
+    SendMsg(CONTROLLER_SHOW);
+    m_external_controller->SetHandshake(m_pipe_buffer);
+    m_pipe_buffer.clear();
+    m_pipe_batch = false;
+
+    // the result of the previous connection is stale from now on
+    g_atomic_int_set(&m_connected_status, -2);
     if (!m_external_controller->StartClient()) {
         g_critical("failed to start SPICE client");
+        g_atomic_int_set(&m_connected_status, 1);
+        RemoveTrustStoreFile();
+        return;
+    }
+}
+
+bool nsPluginInstance::IsClientConnected() const
+{
+    return m_external_controller != NULL &&
+           m_external_controller->GetState() == SpiceController::STATE_CONNECTED;
+}
+
+// called from the client thread, once the handshake has been sent or the
+// client could not be started
+void nsPluginInstance::OnSpiceClientReady(SpiceController::LaunchResult result)
+{
+    NPN_PluginThreadAsyncCall(m_instance, ClientReadyCallback,
+                              new ClientNotification(this, m_external_controller->GetAttempt(),
+                                                     result));
+}
+
+void nsPluginInstance::ClientReadyCallback(void *data)
+{
+    ClientNotification *notification = static_cast<ClientNotification *>(data);
+    nsPluginInstance *plugin = notification->plugin;
+
+    if (plugin->IsCurrentAttempt(notification->attempt))
+        plugin->OnClientReady((SpiceController::LaunchResult)notification->code);
+    else
+        g_debug("ignoring the launch result of a previous client");
+    delete notification;
+}
+
+bool nsPluginInstance::IsCurrentAttempt(unsigned int attempt) const
+{
+    return m_external_controller != NULL &&
+           m_external_controller->GetAttempt() == attempt;
+}
+
+void nsPluginInstance::OnClientReady(SpiceController::LaunchResult result)
+{
+    if (result == SpiceController::LAUNCH_CANCELLED)
+    {
+        g_debug("client launch cancelled");
         return;
     }
 
-    if (m_external_controller->Connect(10) != 0)
+    if (result == SpiceController::LAUNCH_FAILED)
     {
         g_critical("could not connect to spice client controller");
         return;
     }
 
-    if (!this->CreateTrustStoreFile(m_trust_store)) {
-        g_critical("failed to create trust store");
+    // the exit of a client, which has already gone, is handled next
+    g_atomic_int_set(&m_connected_status, -1);
+    g_debug("connected in %.1f ms: %s",
+            (g_get_monotonic_time() - m_connect_start) / 1000.0,
+            m_external_controller->GetStateHistory().c_str());
+}
+
+void nsPluginInstance::Reconnect()
+{
+    // keep the running client and its controller socket, just send the
+    // connection parameters again; start from scratch only, if there is
+    // no client at all or it has already exited
+    if (!m_external_controller || m_external_controller->IsClientIdle())
+    {
+        g_debug("no running client to reuse, starting a new one");
+        Connect();
         return;
     }
 
-    SendInit();
-    SendStr(CONTROLLER_HOST, m_host_ip);
-    if (port > 0)
-        SendValue(CONTROLLER_PORT, port);
-    if (sport > 0)
-        SendValue(CONTROLLER_SPORT, sport);
-    SendValue(CONTROLLER_FULL_SCREEN,
-            (m_fullscreen == true ? CONTROLLER_SET_FULL_SCREEN : 0) |
-            (m_admin_console == false ? CONTROLLER_AUTO_DISPLAY_RES : 0));
-    SendBool(CONTROLLER_ENABLE_SMARTCARD, m_smartcard);
-    SendStr(CONTROLLER_PASSWORD, m_password);
-    SendStr(CONTROLLER_TLS_CIPHERS, m_cipher_suite);
-    SendStr(CONTROLLER_SET_TITLE, m_title);
-    SendBool(CONTROLLER_SEND_CAD, m_send_ctrlaltdel);
-    SendBool(CONTROLLER_ENABLE_USB_AUTOSHARE, m_usb_auto_share);
-    SendStr(CONTROLLER_USB_FILTER, m_usb_filter);
-    SendStr(CONTROLLER_SECURE_CHANNELS, m_ssl_channels);
-    SendStr(CONTROLLER_CA_FILE, m_trust_store_file);
-    SendStr(CONTROLLER_HOST_SUBJECT, m_host_subject);
-    SendStr(CONTROLLER_HOTKEYS, m_hot_keys);
-    SendValue(CONTROLLER_COLOR_DEPTH, atoi(m_color_depth.c_str()));
-    SendStr(CONTROLLER_DISABLE_EFFECTS, m_disable_effects);
-    SendMsg(CONTROLLER_CONNECT);
-    SendMsg(CONTROLLER_SHOW);
+    // a client still being started or already being stopped is left alone
+    if (!IsClientConnected())
+    {
+        g_debug("client is %s, ignoring reconnect()",
+                SpiceController::GetStateName(m_external_controller->GetState()));
+        return;
+    }
+
+    const int port = portToInt(m_port);
+    const int sport = portToInt(m_secure_port);
+    if (port <= 0 && sport <= 0)
+    {
+        g_warning("invalid ports: '%s', '%s'", m_port.c_str(), m_secure_port.c_str());
+        return;
+    }
 
-    // set connected status
-    m_connected_status = -1;
+    g_debug("reconnecting with the running client");
+    BeginPipeBatch();
+    SendConnectionParams(port, sport);
+    SendMsg(CONTROLLER_CONNECT);
+    EndPipeBatch();
 }
 
 void nsPluginInstance::Show()
 {
+    // before the client is connected, showing it is part of the handshake
+    if (!IsClientConnected())
+        return;
+
     g_debug("sending show message");
     SendMsg(CONTROLLER_SHOW);
 }
 
 void nsPluginInstance::Disconnect()
 {
-    m_external_controller->StopClient();
+    if (m_external_controller)
+        m_external_controller->StopClient();
 }
 
 void nsPluginInstance::ConnectedStatus(int32_t *retval)
 {
-    *retval = m_connected_status;
+    *retval = g_atomic_int_get(&m_connected_status);
 }
 
 void nsPluginInstance::SetLanguageStrings(const char *aSection, const char *aLanguage)
@@ -813,16 +1091,43 @@ void nsPluginInstance::CallOnDisconnected(int code)
     NPN_ReleaseVariantValue(&var_on_disconnected);
 }
 
+// called from the client thread, the script is notified on the main thread
 void nsPluginInstance::OnSpiceClientExit(int exit_code)
 {
-    m_connected_status = m_external_controller->TranslateRC(exit_code);
-    if (!getenv("SPICE_XPI_DEBUG"))
-    {
-        CallOnDisconnected(exit_code);
-        m_external_controller->Disconnect();
-    }
+    NPN_PluginThreadAsyncCall(m_instance, ClientExitCallback,
+                              new ClientNotification(this, m_external_controller->GetAttempt(),
+                                                     exit_code));
+}
+
+void nsPluginInstance::ClientExitCallback(void *data)
+{
+    ClientNotification *notification = static_cast<ClientNotification *>(data);
+    nsPluginInstance *plugin = notification->plugin;
 
+    // a new client has been started in the meantime, the socket and the
+    // trust store file are its own now
+    if (plugin->IsCurrentAttempt(notification->attempt))
+        plugin->OnClientExit(notification->code);
+    else
+        g_debug("ignoring the exit of a previous client");
+    delete notification;
+}
+
+// the socket and the trust store file are cleaned up before the exit is
+// published, the script may connect again as soon as it learns about it
+void nsPluginInstance::OnClientExit(int exit_code)
+{
+    const bool debug = getenv("SPICE_XPI_DEBUG") != NULL;
+
+    g_debug("client exited: %s", m_external_controller->GetStateHistory().c_str());
+    if (!debug)
+        m_external_controller->Disconnect();
     RemoveTrustStoreFile();
+
+    g_atomic_int_set(&m_connected_status,
+                     m_external_controller->TranslateRC(exit_code));
+    if (!debug)
+        CallOnDisconnected(exit_code);
 }
 
 // ==============================
@@ -56,6 +56,7 @@ extern "C" {
 
 #include "pluginbase.h"
 #include "controller.h"
+#include "controller-handshake.h"
 #include "common.h"
 #include "glib-compat.h"
 
@@ -75,6 +76,7 @@ public:
     // locals
     void Connect();
     void Disconnect();
+    void Reconnect();
     void Show();
     void ConnectedStatus(int32_t *retval);
     void SetLanguageStrings(const char *aSection, const char *aLanguage);
@@ -172,25 +174,73 @@ public:
     char *GetProxy() const;
     void SetProxy(const char *aProxy);
 
+    /* attribute unsigned long ConnectTimeout; */
+    uint32_t GetConnectTimeout() const;
+    void SetConnectTimeout(uint32_t aConnectTimeout);
+
+    /* readonly attribute string ClientLog; */
+    char *GetClientLog() const;
+
     NPObject *GetScriptablePeer();
     
+    void OnSpiceClientReady(SpiceController::LaunchResult result);
     void OnSpiceClientExit(int exit_code);
 
 private:
+    void QueueToPipe(const void *data, uint32_t size);
     void WriteToPipe(const void *data, uint32_t size);
+    void FlushPipe();
+    void BeginPipeBatch();
+    void EndPipeBatch();
     void SendInit();
     void SendMsg(uint32_t id);
     void SendValue(uint32_t id, uint32_t value);
-    void SendStr(uint32_t id, std::string str);
+    void SendStr(uint32_t id, const std::string &str);
     void SendBool(uint32_t id, bool value);
+    void SendField(ControllerHandshake::Index field, const std::string &str);
+    void SendField(ControllerHandshake::Index field, uint32_t value);
+    void UpdateField(ControllerHandshake::Index field, const std::string &str);
+    void UpdateField(ControllerHandshake::Index field, uint32_t value);
+    void SendConnectionParams(int port, int sport);
+    std::string GetConnectHost(int sport) const;
+    uint32_t GetFullScreenFlags() const;
+    bool IsClientConnected() const;
     void CallOnDisconnected(int code);
+
+    // passed from the client thread to the main thread; the attempt tells
+    // the notifications of a previous client, which may arrive after the
+    // next one has been started, from those of the current client
+    struct ClientNotification
+    {
+        ClientNotification(nsPluginInstance *plugin, unsigned int attempt, int code):
+            plugin(plugin),
+            attempt(attempt),
+            code(code)
+        {}
+
+        nsPluginInstance *plugin;
+        unsigned int attempt;
+        int code;
+    };
+
+    bool IsCurrentAttempt(unsigned int attempt) const;
+    void OnClientReady(SpiceController::LaunchResult result);
+    static void ClientReadyCallback(void *data);
+    void OnClientExit(int exit_code);
+    static void ClientExitCallback(void *data);
   
 private:
+    void CreateController();
     bool CreateTrustStoreFile(const std::string &trust_store);
     bool RemoveTrustStoreFile();
 
-    int32_t m_connected_status;
+    // -2 before the first connection and while one is being started, -1
+    // while connected, otherwise the result of the last connection
+    gint m_connected_status;
+    gint64 m_connect_start;
     SpiceController *m_external_controller;
+    std::string m_pipe_buffer;
+    bool m_pipe_batch;
 
     NPP m_instance;
     NPBool m_initialized;
@@ -220,6 +270,7 @@ private:
     std::string m_color_depth;
     std::string m_disable_effects;
     std::string m_proxy;
+    uint32_t m_connect_timeout;
     
     NPObject *m_scriptable_peer;
     std::string m_trust_store_file;
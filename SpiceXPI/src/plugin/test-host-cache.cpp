@@ -0,0 +1,131 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ *   Version: MPL 1.1/GPL 2.0/LGPL 2.1
+ *
+ *   The contents of this file are subject to the Mozilla Public License Version
+ *   1.1 (the "License"); you may not use this file except in compliance with
+ *   the License. You may obtain a copy of the License at
+ *   http://www.mozilla.org/MPL/
+ *
+ *   Software distributed under the License is distributed on an "AS IS" basis,
+ *   WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+ *   for the specific language governing rights and limitations under the
+ *   License.
+ *
+ *   Copyright 2026, Red Hat Inc.
+ *
+ *   Alternatively, the contents of this file may be used under the terms of
+ *   either the GNU General Public License Version 2 or later (the "GPL"), or
+ *   the GNU Lesser General Public License Version 2.1 or later (the "LGPL"),
+ *   in which case the provisions of the GPL or the LGPL are applicable instead
+ *   of those above. If you wish to allow use of your version of this file only
+ *   under the terms of either the GPL or the LGPL, and not to allow others to
+ *   use your version of this file under the terms of the MPL, indicate your
+ *   decision by deleting the provisions above and replace them with the notice
+ *   and other provisions required by the GPL or the LGPL. If you do not delete
+ *   the provisions above, a recipient may use your version of this file under
+ *   the terms of any one of the MPL, the GPL or the LGPL.
+ *
+ * ***** END LICENSE BLOCK ***** */
+
+// Checks the host name cache against the names of /etc/hosts, so that it
+// runs without a name server: localhost must resolve, a name in the
+// reserved .invalid domain must not.
+
+#include "config.h"
+
+#include <string>
+#include <glib.h>
+#include <gio/gio.h>
+
+#include "host-cache.h"
+
+#define LOOKUP_TIMEOUT 10 // s
+
+static gboolean lookup_timeout(gpointer user_data)
+{
+    *static_cast<bool *>(user_data) = true;
+    return FALSE;
+}
+
+static void wait_for_lookup(const std::string &host)
+{
+    bool timed_out = false;
+    guint id = g_timeout_add_seconds(LOOKUP_TIMEOUT, lookup_timeout, &timed_out);
+
+    while (host_lookup_pending(host) && !timed_out)
+        g_main_context_iteration(NULL, TRUE);
+
+    g_assert(!timed_out);
+    g_source_remove(id);
+}
+
+// an address is not looked up
+static void test_address(void)
+{
+    host_lookup_start("127.0.0.1");
+    g_assert(!host_lookup_pending("127.0.0.1"));
+    g_assert(host_lookup_cached("127.0.0.1") == "127.0.0.1");
+}
+
+// localhost resolves to its only address, or is kept as a name, when
+// /etc/hosts lists several
+static void test_localhost(void)
+{
+    GResolver *resolver = g_resolver_get_default();
+    GList *addresses = g_resolver_lookup_by_name(resolver, "localhost", NULL, NULL);
+    std::string expected("localhost");
+
+    g_assert(addresses != NULL);
+    if (addresses->next == NULL) {
+        gchar *address = g_inet_address_to_string(G_INET_ADDRESS(addresses->data));
+        expected = address;
+        g_free(address);
+    }
+    g_resolver_free_addresses(addresses);
+    g_object_unref(resolver);
+
+    host_lookup_start("localhost");
+    g_assert(host_lookup_pending("localhost"));
+    g_assert(host_lookup_cached("localhost") == "localhost");
+    wait_for_lookup("localhost");
+    g_assert(host_lookup_cached("localhost") == expected);
+
+    // a fresh entry is not looked up again
+    host_lookup_start("localhost");
+    g_assert(!host_lookup_pending("localhost"));
+}
+
+// a failed lookup leaves the name to the client
+static void test_unknown(void)
+{
+    host_lookup_start("spice-xpi-test.invalid");
+    wait_for_lookup("spice-xpi-test.invalid");
+    g_assert(host_lookup_cached("spice-xpi-test.invalid") == "spice-xpi-test.invalid");
+}
+
+// a cancelled lookup has completed, once host_lookup_cancel() returns,
+// and is dropped from the cache
+static void test_cancel(void)
+{
+    host_lookup_start("spice-xpi-cancel.invalid");
+    g_assert(host_lookup_pending("spice-xpi-cancel.invalid"));
+    host_lookup_cancel();
+    g_assert(!host_lookup_pending("spice-xpi-cancel.invalid"));
+    g_assert(host_lookup_cached("spice-xpi-cancel.invalid") == "spice-xpi-cancel.invalid");
+}
+
+int main(int argc, char *argv[])
+{
+#if !GLIB_CHECK_VERSION(2, 35, 0)
+    g_type_init();
+#endif
+    // the cache is disabled by default
+    g_setenv("SPICE_XPI_DNS_CACHE_TTL", "60", TRUE);
+
+    test_address();
+    test_localhost();
+    test_unknown();
+    test_cancel();
+
+    return 0;
+}
@@ -24,36 +24,45 @@
 class Attribute
 {
 public:
+    // how the attribute is sent to the client in the controller handshake,
+    // see the [controller(message, encoding)] annotation
+    enum ControllerEncoding {
+        CONTROLLER_NONE,    // not part of the handshake
+        CONTROLLER_STR,     // string, not sent when empty
+        CONTROLLER_VALUE,   // 32-bit value, not sent when zero
+        CONTROLLER_BOOL     // 32-bit value, always sent
+    };
+
+public:
+    // identifier is an interned string, see InternTable
     Attribute(Token::TokenType type, const std::string &identifier, bool readonly = false):
         m_type(type),
-        m_identifier(identifier),
-        m_readonly(readonly)
-    {}
-
-    Attribute(const Attribute &copy):
-        m_type(copy.m_type),
-        m_identifier(copy.m_identifier),
-        m_readonly(copy.m_readonly)
-    {}
-
-    ~Attribute()
+        m_identifier(&identifier),
+        m_readonly(readonly),
+        m_controller_message(NULL),
+        m_controller_encoding(CONTROLLER_NONE)
     {}
 
     Token::TokenType getType() const { return m_type; }
-    std::string getIdentifier() const { return m_identifier; }
+    const std::string &getIdentifier() const { return *m_identifier; }
+    bool isReadonly() const { return m_readonly; }
 
-    Attribute &operator=(const Attribute &rhs)
+    // message is an interned string, e.g. "CONTROLLER_HOST"
+    void setController(const std::string &message, ControllerEncoding encoding)
     {
-        m_type = rhs.m_type;
-        m_identifier = rhs.m_identifier;
-        m_readonly = rhs.m_readonly;
-        return *this;
+        m_controller_message = &message;
+        m_controller_encoding = encoding;
     }
 
+    ControllerEncoding getControllerEncoding() const { return m_controller_encoding; }
+    const std::string &getControllerMessage() const { return *m_controller_message; }
+
 private:
     Token::TokenType m_type;
-    std::string m_identifier;
+    const std::string *m_identifier;
     bool m_readonly;
+    const std::string *m_controller_message;
+    ControllerEncoding m_controller_encoding;
 };
 
 #endif // ATTRIBUTE_H
@@ -0,0 +1,209 @@
+/* ***** BEGIN LICENSE BLOCK *****
+*   Copyright (C) 2026, Red Hat Inc.
+*
+*   This program is free software; you can redistribute it and/or
+*   modify it under the terms of the GNU General Public License as
+*   published by the Free Software Foundation; either version 2 of
+*   the License, or (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program. If not, see <http://www.gnu.org/licenses/>.
+* ***** END LICENSE BLOCK ***** */
+
+#include "benchmarkgenerator.h"
+
+BenchmarkGenerator::BenchmarkGenerator(const std::vector<Attribute> &attributes,
+    const std::vector<Method> &methods):
+    m_attributes(attributes),
+    m_methods(methods),
+    m_output()
+{
+}
+
+BenchmarkGenerator::~BenchmarkGenerator()
+{
+}
+
+bool BenchmarkGenerator::generate()
+{
+    generateHeader();
+    generateBenchmarks();
+    generateScript();
+    generateTable();
+    generateFooter();
+    return m_output.writeTo(std::cout);
+}
+
+void BenchmarkGenerator::generateHeader()
+{
+    m_output << "<html>\n"
+             << "<head>\n"
+             << "<title>Spice-XPI call benchmark (generated)</title>\n"
+             << "<style type=\"text/css\">\n"
+             << "th, td {\n"
+             << "    text-align: left;\n"
+             << "    padding-right: 2em;\n"
+             << "}\n\n"
+             << "td.result {\n"
+             << "    text-align: right;\n"
+             << "    font-family: monospace;\n"
+             << "}\n"
+             << "</style>\n"
+             << "</head>\n\n"
+             << "<body onload=\"bodyLoad()\">\n\n"
+             << "<center>\n"
+             << "<h1>SPICE xpi call benchmark (generated)</h1>\n"
+             << "This page was autogenerated using IDL description and should not be modified by hand.<br>\n"
+             << "Every checked row is called the given number of times through the plugin;\n"
+             << "attributes are written back with the value just read.\n</center>\n<br/>\n\n"
+             << "<embed type=\"application/x-spice\" width=\"0\" height=\"0\" id=\"spice-xpi\"/><br/>\n\n"
+             << "<script type=\"text/javascript\">\n\n"
+             << "var embed = document.getElementById(\"spice-xpi\");\n\n";
+}
+
+void BenchmarkGenerator::generateBenchmarks()
+{
+    m_output << "var benchmarks = [\n";
+
+    bool first = true;
+    std::vector<Attribute>::const_iterator ita;
+    for (ita = m_attributes.begin(); ita != m_attributes.end(); ++ita) {
+        const std::string &id = ita->getIdentifier();
+        m_output << (first ? "" : ",\n")
+                 << "    { name: \"" << id << "\",\n"
+                 << "      get: function() { return embed." << id << "; }";
+        if (!ita->isReadonly())
+            m_output << ",\n      set: function(value) { embed." << id << " = value; }";
+        m_output << " }";
+        first = false;
+    }
+
+    std::vector<Method>::const_iterator itm;
+    for (itm = m_methods.begin(); itm != m_methods.end(); ++itm) {
+        m_output << (first ? "" : ",\n")
+                 << "    { name: \"" << itm->getIdentifier() << "\",\n"
+                 << "      invoke: function() { embed." << itm->getIdentifier() << "(";
+        Method::ParamIterator itp;
+        for (itp = itm->paramsBegin(); itp != itm->paramsEnd(); ++itp) {
+            m_output << (itp == itm->paramsBegin() ? "" : ", ")
+                     << defaultArgument(itp->getType());
+        }
+        m_output << "); } }";
+        first = false;
+    }
+
+    m_output << "\n];\n\n";
+}
+
+void BenchmarkGenerator::generateScript()
+{
+    m_output << "function bodyLoad()\n{\n"
+             << "    var mime = navigator.mimeTypes[\"application/x-spice\"];\n"
+             << "    document.getElementById(\"plugin\").innerHTML =\n"
+             << "        mime && mime.enabledPlugin ? mime.enabledPlugin.description : \"not found\";\n"
+             << "}\n\n"
+             << "// ns per call, after a warm-up of a tenth of the iterations\n"
+             << "function measure(fn, iterations)\n{\n"
+             << "    var i;\n"
+             << "    for (i = 0; i < iterations / 10; ++i)\n"
+             << "        fn();\n"
+             << "    var start = performance.now();\n"
+             << "    for (i = 0; i < iterations; ++i)\n"
+             << "        fn();\n"
+             << "    return (performance.now() - start) * 1e6 / iterations;\n"
+             << "}\n\n"
+             << "function show(id, ns)\n{\n"
+             << "    document.getElementById(id).innerHTML = ns.toFixed(1);\n"
+             << "}\n\n"
+             << "function run()\n{\n"
+             << "    var iterations = parseInt(document.getElementById(\"iterations\").value);\n"
+             << "    if (!(iterations > 0))\n"
+             << "        return;\n\n"
+             << "    for (var i = 0; i < benchmarks.length; ++i) {\n"
+             << "        var b = benchmarks[i];\n"
+             << "        if (!document.getElementById(b.name + \"Toggled\").checked)\n"
+             << "            continue;\n"
+             << "        if (b.get)\n"
+             << "            show(b.name + \"Get\", measure(b.get, iterations));\n"
+             << "        if (b.set) {\n"
+             << "            var value = b.get();\n"
+             << "            show(b.name + \"Set\", measure(function() { b.set(value); }, iterations));\n"
+             << "        }\n"
+             << "        if (b.invoke)\n"
+             << "            show(b.name + \"Invoke\", measure(b.invoke, iterations));\n"
+             << "    }\n"
+             << "}\n\n"
+             << "</script>\n\n";
+}
+
+void BenchmarkGenerator::generateTable()
+{
+    m_output << "<center>\n\n"
+             << "Plugin: <span id=\"plugin\"></span><br/><br/>\n"
+             << "Iterations: <input id=\"iterations\" type=\"text\" size=\"10\" value=\"10000\"/>\n"
+             << "<input type=\"button\" value=\"Run\" style=\"min-width: 180px\" onclick=\"run()\"/>\n"
+             << "<br/><br/>\n\n"
+             << "<table id=\"results\">\n"
+             << "<thead><tr><th></th><th>name</th><th>kind</th>"
+             << "<th>get [ns/op]</th><th>set [ns/op]</th><th>invoke [ns/op]</th></tr></thead>\n"
+             << "<tbody>\n";
+
+    std::vector<Attribute>::const_iterator ita;
+    for (ita = m_attributes.begin(); ita != m_attributes.end(); ++ita) {
+        generateRow(ita->getIdentifier(),
+                    ita->isReadonly() ? "readonly attribute" : "attribute", true);
+    }
+
+    // methods like connect() would start or stop the client on every call
+    std::vector<Method>::const_iterator itm;
+    for (itm = m_methods.begin(); itm != m_methods.end(); ++itm)
+        generateRow(itm->getIdentifier(), "method", !methodHasEffects(*itm));
+
+    m_output << "</tbody>\n"
+             << "</table>\n\n"
+             << "</center>\n\n";
+}
+
+void BenchmarkGenerator::generateRow(const std::string &name, const char *kind, bool checked)
+{
+    m_output << "<tr>\n<td><input type=\"checkbox\" id=\"" << name << "Toggled\" "
+             << (checked ? "checked " : "") << "/></td>\n"
+             << "<td>" << name << "</td>\n"
+             << "<td>" << kind << "</td>\n"
+             << "<td class=\"result\" id=\"" << name << "Get\"></td>\n"
+             << "<td class=\"result\" id=\"" << name << "Set\"></td>\n"
+             << "<td class=\"result\" id=\"" << name << "Invoke\"></td>\n"
+             << "</tr>\n";
+}
+
+void BenchmarkGenerator::generateFooter()
+{
+    m_output << "</body>\n"
+             << "</html>\n";
+}
+
+const char *BenchmarkGenerator::defaultArgument(Token::TokenType type)
+{
+    switch (type) {
+    case Token::T_STRING:
+    case Token::T_WSTRING:
+    case Token::T_CHAR:
+    case Token::T_WCHAR:
+        return "\"\"";
+    case Token::T_BOOLEAN:
+        return "false";
+    default:
+        return "0";
+    }
+}
+
+// void methods without parameters are actions (connect, show, ...)
+bool BenchmarkGenerator::methodHasEffects(const Method &method)
+{
+    return method.getType() == Token::T_VOID && method.paramsBegin() == method.paramsEnd();
+}
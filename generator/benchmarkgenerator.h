@@ -0,0 +1,58 @@
+/* ***** BEGIN LICENSE BLOCK *****
+*   Copyright (C) 2026, Red Hat Inc.
+*
+*   This program is free software; you can redistribute it and/or
+*   modify it under the terms of the GNU General Public License as
+*   published by the Free Software Foundation; either version 2 of
+*   the License, or (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program. If not, see <http://www.gnu.org/licenses/>.
+* ***** END LICENSE BLOCK ***** */
+
+#ifndef BENCHMARKGENERATOR_H
+#define BENCHMARKGENERATOR_H
+
+#include <string>
+#include <vector>
+#include "attribute.h"
+#include "method.h"
+#include "outputbuffer.h"
+
+// Emits a page, which measures the cost of NPRuntime calls into the
+// plugin: every attribute is read and written back with its own value
+// and every method is invoked with empty arguments, N times in a loop
+// timed by performance.now(), and the results are shown in ns/op.
+class BenchmarkGenerator
+{
+public:
+    BenchmarkGenerator(const std::vector<Attribute> &attributes,
+                       const std::vector<Method> &methods);
+    ~BenchmarkGenerator();
+
+    // writes the page to std::cout at once
+    bool generate();
+
+private:
+    void generateHeader();
+    void generateBenchmarks();
+    void generateScript();
+    void generateTable();
+    void generateFooter();
+    void generateRow(const std::string &name, const char *kind, bool checked);
+
+    static const char *defaultArgument(Token::TokenType type);
+    static bool methodHasEffects(const Method &method);
+
+private:
+    const std::vector<Attribute> &m_attributes;
+    const std::vector<Method> &m_methods;
+    OutputBuffer m_output;
+};
+
+#endif // BENCHMARKGENERATOR_H
@@ -0,0 +1,210 @@
+/* ***** BEGIN LICENSE BLOCK *****
+*   Copyright (C) 2026, Red Hat Inc.
+*
+*   This program is free software; you can redistribute it and/or
+*   modify it under the terms of the GNU General Public License as
+*   published by the Free Software Foundation; either version 2 of
+*   the License, or (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program. If not, see <http://www.gnu.org/licenses/>.
+* ***** END LICENSE BLOCK ***** */
+
+#include "controllergenerator.h"
+
+ControllerGenerator::ControllerGenerator(const std::vector<Attribute> &attributes):
+    m_attributes(attributes),
+    m_output()
+{
+}
+
+ControllerGenerator::~ControllerGenerator()
+{
+}
+
+bool ControllerGenerator::generate()
+{
+    std::vector<const Attribute *> fields;
+    std::vector<Attribute>::const_iterator it;
+    for (it = m_attributes.begin(); it != m_attributes.end(); ++it) {
+        if (it->getControllerEncoding() != Attribute::CONTROLLER_NONE)
+            fields.push_back(&*it);
+    }
+
+    m_output << "/* Generated by spice-xpi-generator from the [controller(...)] annotations\n"
+             << " * of nsISpicec.idl, do not edit. Regenerate with:\n"
+             << " *   spice-xpi-generator -m controller -i nsISpicec.idl -o controller-handshake.h\n"
+             << " */\n\n"
+             << "#ifndef SPICE_CONTROLLER_HANDSHAKE_H\n"
+             << "#define SPICE_CONTROLLER_HANDSHAKE_H\n\n"
+             << "#include <cstring>\n"
+             << "#include <string>\n"
+             << "#include <spice/controller_prot.h>\n\n"
+             << "// Values of the annotated attributes, serialized into the controller\n"
+             << "// messages of the handshake. A string, which is NULL or empty, and a\n"
+             << "// zero value are not sent; a bool is always sent.\n"
+             << "class ControllerHandshake\n{\n"
+             << "public:\n"
+             << "    enum Encoding {\n"
+             << "        ENCODING_STR,\n"
+             << "        ENCODING_VALUE,\n"
+             << "        ENCODING_BOOL\n"
+             << "    };\n\n"
+             << "    struct Field {\n"
+             << "        const char *attribute;\n"
+             << "        uint32_t message;\n"
+             << "        Encoding encoding;\n"
+             << "    };\n\n";
+
+    generateFields(fields);
+    generateSerializer(fields);
+
+    m_output << "#endif // SPICE_CONTROLLER_HANDSHAKE_H\n";
+    return m_output.writeTo(std::cout);
+}
+
+void ControllerGenerator::generateFields(const std::vector<const Attribute *> &fields)
+{
+    std::vector<const Attribute *>::const_iterator it;
+
+    m_output << "    // index of each attribute in Fields()\n"
+             << "    enum Index {\n";
+    for (it = fields.begin(); it != fields.end(); ++it)
+        m_output << "        FIELD_" << (*it)->getIdentifier() << ",\n";
+    m_output << "        FIELD_COUNT\n"
+             << "    };\n\n"
+             << "    // descriptor table, in the order of the messages\n"
+             << "    static const Field *Fields()\n    {\n"
+             << "        static const Field fields[FIELD_COUNT] = {\n";
+    for (it = fields.begin(); it != fields.end(); ++it) {
+        m_output << "            { \"" << (*it)->getIdentifier() << "\", "
+                 << (*it)->getControllerMessage() << ", "
+                 << encodingName((*it)->getControllerEncoding()) << " }"
+                 << (it + 1 != fields.end() ? ",\n" : "\n");
+    }
+    m_output << "        };\n"
+             << "        return fields;\n"
+             << "    }\n\n";
+
+    m_output << "    ControllerHandshake()";
+    for (it = fields.begin(); it != fields.end(); ++it) {
+        m_output << (it == fields.begin() ? ":\n" : ",\n")
+                 << "        " << (*it)->getIdentifier()
+                 << ((*it)->getControllerEncoding() == Attribute::CONTROLLER_STR ? "(NULL)" :
+                     (*it)->getControllerEncoding() == Attribute::CONTROLLER_BOOL ? "(false)" : "(0)");
+    }
+    m_output << "\n    {}\n\n";
+
+    for (it = fields.begin(); it != fields.end(); ++it) {
+        switch ((*it)->getControllerEncoding()) {
+        case Attribute::CONTROLLER_STR:
+            m_output << "    const std::string *";
+            break;
+        case Attribute::CONTROLLER_VALUE:
+            m_output << "    uint32_t ";
+            break;
+        case Attribute::CONTROLLER_BOOL:
+            m_output << "    bool ";
+            break;
+        case Attribute::CONTROLLER_NONE:
+            break;
+        }
+        m_output << (*it)->getIdentifier() << ";\n";
+    }
+    m_output << "\n";
+}
+
+void ControllerGenerator::generateSerializer(const std::vector<const Attribute *> &fields)
+{
+    std::vector<const Attribute *>::const_iterator it;
+
+    m_output << "    // number of bytes written by Write()\n"
+             << "    size_t Size() const\n    {\n"
+             << "        size_t size = 0;\n";
+    for (it = fields.begin(); it != fields.end(); ++it) {
+        const std::string &id = (*it)->getIdentifier();
+        switch ((*it)->getControllerEncoding()) {
+        case Attribute::CONTROLLER_STR:
+            m_output << "        size += StrSize(" << id << ");\n";
+            break;
+        case Attribute::CONTROLLER_VALUE:
+            m_output << "        size += " << id << " ? sizeof(ControllerValue) : 0;\n";
+            break;
+        case Attribute::CONTROLLER_BOOL:
+            m_output << "        size += sizeof(ControllerValue); // " << id << "\n";
+            break;
+        case Attribute::CONTROLLER_NONE:
+            break;
+        }
+    }
+    m_output << "        return size;\n"
+             << "    }\n\n";
+
+    m_output << "    char *Write(char *buf) const\n    {\n";
+    for (it = fields.begin(); it != fields.end(); ++it) {
+        const std::string &id = (*it)->getIdentifier();
+        const std::string &message = (*it)->getControllerMessage();
+        switch ((*it)->getControllerEncoding()) {
+        case Attribute::CONTROLLER_STR:
+            m_output << "        buf = WriteStr(buf, " << message << ", " << id << ");\n";
+            break;
+        case Attribute::CONTROLLER_VALUE:
+            m_output << "        if (" << id << ")\n"
+                     << "            buf = WriteValue(buf, " << message << ", " << id << ");\n";
+            break;
+        case Attribute::CONTROLLER_BOOL:
+            m_output << "        buf = WriteValue(buf, " << message << ", " << id << ");\n";
+            break;
+        case Attribute::CONTROLLER_NONE:
+            break;
+        }
+    }
+    m_output << "        return buf;\n"
+             << "    }\n\n";
+
+    m_output << "    // serializes the whole handshake with a single allocation\n"
+             << "    void AppendTo(std::string &out) const\n    {\n"
+             << "        const size_t offset = out.size();\n"
+             << "        out.resize(offset + Size());\n"
+             << "        Write(&out[offset]);\n"
+             << "    }\n\n"
+             << "private:\n"
+             << "    static size_t StrSize(const std::string *str)\n    {\n"
+             << "        return str && !str->empty() ? sizeof(ControllerData) + str->size() + 1 : 0;\n"
+             << "    }\n\n"
+             << "    static char *WriteStr(char *buf, uint32_t id, const std::string *str)\n    {\n"
+             << "        const size_t size = StrSize(str);\n"
+             << "        if (!size)\n"
+             << "            return buf;\n\n"
+             << "        ControllerMsg msg = { id, static_cast<uint32_t>(size) };\n"
+             << "        memcpy(buf, &msg, sizeof(msg));\n"
+             << "        memcpy(buf + sizeof(ControllerData), str->c_str(), str->size() + 1);\n"
+             << "        return buf + size;\n"
+             << "    }\n\n"
+             << "    static char *WriteValue(char *buf, uint32_t id, uint32_t value)\n    {\n"
+             << "        ControllerValue msg = { {id, sizeof(msg)}, value };\n"
+             << "        memcpy(buf, &msg, sizeof(msg));\n"
+             << "        return buf + sizeof(msg);\n"
+             << "    }\n"
+             << "};\n\n";
+}
+
+const char *ControllerGenerator::encodingName(Attribute::ControllerEncoding encoding)
+{
+    switch (encoding) {
+    case Attribute::CONTROLLER_STR:
+        return "ENCODING_STR";
+    case Attribute::CONTROLLER_VALUE:
+        return "ENCODING_VALUE";
+    case Attribute::CONTROLLER_BOOL:
+        return "ENCODING_BOOL";
+    case Attribute::CONTROLLER_NONE:
+        break;
+    }
+    return "";
+}
@@ -0,0 +1,50 @@
+/* ***** BEGIN LICENSE BLOCK *****
+*   Copyright (C) 2026, Red Hat Inc.
+*
+*   This program is free software; you can redistribute it and/or
+*   modify it under the terms of the GNU General Public License as
+*   published by the Free Software Foundation; either version 2 of
+*   the License, or (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program. If not, see <http://www.gnu.org/licenses/>.
+* ***** END LICENSE BLOCK ***** */
+
+#ifndef CONTROLLERGENERATOR_H
+#define CONTROLLERGENERATOR_H
+
+#include <string>
+#include <vector>
+#include "attribute.h"
+#include "outputbuffer.h"
+
+// Emits the C++ header with the controller handshake of the plugin: a
+// descriptor table of the attributes annotated with
+// [controller(message, encoding)] and a serializer, which is unrolled
+// over those attributes, so it does not look the encodings up at run time.
+class ControllerGenerator
+{
+public:
+    ControllerGenerator(const std::vector<Attribute> &attributes);
+    ~ControllerGenerator();
+
+    // writes the header to std::cout at once
+    bool generate();
+
+private:
+    void generateFields(const std::vector<const Attribute *> &fields);
+    void generateSerializer(const std::vector<const Attribute *> &fields);
+
+    static const char *encodingName(Attribute::ControllerEncoding encoding);
+
+private:
+    const std::vector<Attribute> &m_attributes;
+    OutputBuffer m_output;
+};
+
+#endif // CONTROLLERGENERATOR_H
@@ -0,0 +1,35 @@
+/* ***** BEGIN LICENSE BLOCK *****
+*   Copyright (C) 2026, Red Hat Inc.
+*
+*   This program is free software; you can redistribute it and/or
+*   modify it under the terms of the GNU General Public License as
+*   published by the Free Software Foundation; either version 2 of
+*   the License, or (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program. If not, see <http://www.gnu.org/licenses/>.
+* ***** END LICENSE BLOCK ***** */
+
+#include <cstddef>
+#include <stdint.h>
+#include "parser.h"
+#include "scannerinput.h"
+
+// libFuzzer target of the scanner and the parser, built with
+// --enable-fuzzer. The input is lexed in place, without a copy, so that
+// a read past its end is caught by the sanitizers.
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    ScannerInput input;
+    input.assign(reinterpret_cast<const char *>(data), size);
+
+    Parser parser(input);
+    parser.parse();
+    return 0;
+}
@@ -21,208 +21,277 @@
 #include <cctype>
 #include "generator.h"
 
-std::set<std::string> Generator::s_default_attributes;
-std::set<std::string> Generator::s_default_methods;
-std::map<std::string, std::string> Generator::s_default_attribute_values;
+namespace {
 
-Generator::Generator(const std::list<Attribute> &attributes,
-    const std::list<Method> &methods):
+std::set<std::string> default_attributes()
+{
+    std::set<std::string> attributes;
+    attributes.insert("hostip");
+    attributes.insert("port");
+    attributes.insert("adminconsole");
+    attributes.insert("hotkey");
+    attributes.insert("smartcard");
+    return attributes;
+}
+
+std::set<std::string> default_methods()
+{
+    std::set<std::string> methods;
+    methods.insert("setlanguagestringssection");
+    methods.insert("setlanguagestringslang");
+    methods.insert("setusbfilterfilter");
+    return methods;
+}
+
+std::map<std::string, std::string> default_attribute_values()
+{
+    std::map<std::string, std::string> values;
+    values["adminconsole"] = "true";
+    values["hotkey"] = "toggle-fullscreen=shift+f11," \
+        "release-cursor=shift+f12,smartcard-insert=shift+f8,smartcard-remove=shift+f9";
+    values["usblistenport"] = "32023";
+    return values;
+}
+
+} // unnamed namespace
+
+// filled in once, before main() runs
+const std::set<std::string> Generator::s_default_attributes(default_attributes());
+const std::set<std::string> Generator::s_default_methods(default_methods());
+const std::map<std::string, std::string> Generator::s_default_attribute_values(
+    default_attribute_values());
+
+Generator::Generator(const std::vector<Attribute> &attributes,
+    const std::vector<Method> &methods):
     m_attributes(attributes),
-    m_methods(methods)
+    m_methods(methods),
+    m_output()
 {
-    init();
 }
 
 Generator::~Generator()
 {
 }
 
-void Generator::init()
+bool Generator::defaultAttributeValue(const Attribute &attr, std::string &value)
 {
-    if (!s_default_attributes.empty())
-        return;
-
-    s_default_attributes.insert("hostip");
-    s_default_attributes.insert("port");
-    s_default_attributes.insert("adminconsole");
-    s_default_attributes.insert("hotkey");
-    s_default_attributes.insert("smartcard");
-    s_default_methods.insert("setlanguagestringssection");
-    s_default_methods.insert("setlanguagestringslang");
-    s_default_methods.insert("setusbfilterfilter");
-    s_default_attribute_values["adminconsole"] = "checked ";
-    s_default_attribute_values["hotkey"] = "value=\"toggle-fullscreen=shift+f11," \
-        "release-cursor=shift+f12,smartcard-insert=shift+f8,smartcard-remove=shift+f9\" ";
-    s_default_attribute_values["usblistenport"] = "value=\"32023\" ";
+    std::string id(lowerString(attr.getIdentifier()));
+    std::map<std::string, std::string>::const_iterator found = s_default_attribute_values.find(id);
+    if (found == s_default_attribute_values.end())
+        return false;
+
+    value = found->second;
+    return true;
 }
 
-void Generator::generate()
+bool Generator::generate()
 {
+    m_output.reserve(estimateSize());
     generateHeader();
     generateConnectVars();
     generateContent();
     generateFooter();
+    return m_output.writeTo(std::cout);
+}
+
+size_t Generator::estimateSize() const
+{
+    // fixed parts of the page are below 8 KiB, a table row with its
+    // script line takes about 400 bytes plus a few copies of the name
+    size_t size = 8192;
+    std::vector<Attribute>::const_iterator ita;
+    for (ita = m_attributes.begin(); ita != m_attributes.end(); ++ita)
+        size += 400 + 8 * ita->getIdentifier().size();
+
+    std::vector<Method>::const_iterator itm;
+    for (itm = m_methods.begin(); itm != m_methods.end(); ++itm) {
+        size += 100 + 2 * itm->getIdentifier().size();
+        Method::ParamIterator itp;
+        for (itp = itm->paramsBegin(); itp != itm->paramsEnd(); ++itp)
+            size += 300 + 8 * (itm->getIdentifier().size() + itp->getIdentifier().size());
+    }
+    return size;
 }
 
 void Generator::generateHeader()
 {
-    std::cout << "<html>\n"
-              << "<head>\n"
-              << "<title>Spice-XPI test page (generated)</title>\n"
-              << "<style type=\"text/css\">\n"
-              << "caption {\n"
-              << "    text-align: left;\n"
-              << "    font-weight: bold;\n"
-              << "}\n\n"
-              << "th {\n"
-              << "    text-align: left;\n"
-              << "}\n"
-              << "</style>\n"
-              << "</head>\n\n"
-              << "<body onload=\"bodyLoad()\" onunload=\"bodyUnload()\">\n\n"
-              << "<center>\n"
-              << "<h1>SPICE xpi test page (generated)</h1>\n"
-              << "This page was autogenerated using IDL description and should not be modified by hand.<br>\n"
-              << "Disabled (greyed out) values are passed\n"
-              << "to SPICE xpi as empty variables.\n</center>\n<br/>\n\n"
-              << "<embed type=\"application/x-spice\" width=\"0\" height=\"0\" id=\"spice-xpi\"/><br/>\n\n"
-              << "<script type=\"text/javascript\">\n\n"
-              << "var embed = document.getElementById(\"spice-xpi\");\n\n"
-              << "function bodyLoad()\n{\n    log(\"Body Load\");\n};\n\n"
-              << "function bodyUnload()\n{\n    log(\"Body Unload\");\n}\n\n"
-              << "function connect()\n{\n"
-              << "    setConnectVars();\n"
-              << "    SetUsbFilter();\n"
-              << "    embed.connect();\n"
-              << "    log(\"Connect: host '\" + embed.hostIP + \"', port '\" + "
-              << "embed.port\n        + \"', secure port '\" + embed.SecurePort + "
-              << "\"', USB port '\" +\n        embed.UsbListenPort + \"'\");\n}\n\n"
-              << "function disconnect()\n{\n"
-              << "    embed.disconnect();\n"
-              << "    log(\"Disconnect\");\n}\n\n"
-              << "function OnDisconnected(msg)\n{\n    log(\"Disconnected, return code: \" + msg);\n}\n\n"
-              << "function log(message)\n{\n"
-              << "    var log = document.getElementById(\"log\");\n"
-              << "    var ts = new Date().toString() + \": \";\n"
-              << "    var newRow = document.createElement(\"tr\");\n"
-              << "    var tsCell = document.createElement(\"td\");\n"
-              << "    var msgCell = document.createElement(\"td\");\n\n"
-              << "    tsCell.innerHTML = ts;\n"
-              << "    msgCell.innerHTML = message;\n\n"
-              << "    newRow.appendChild(tsCell);\n"
-              << "    newRow.appendChild(msgCell);\n"
-              << "    log.insertBefore(newRow, log.firstChild);\n}\n\n"
-              << "function setLanguageStrings()\n{\n"
-              << "    section = document.getElementById(\"SetLanguageStringssectionToggled\").checked ?\n"
-              << "        document.getElementById(\"SetLanguageStringssection\").value : \"\";\n"
-              << "    lang = document.getElementById(\"SetLanguageStringslangToggled\").checked ?\n"
-              << "        document.getElementById(\"SetLanguageStringslang\").value : \"\";\n"
-              << "    embed.SetLanguageStrings(section, lang);\n"
-              << "    log(\"Language Strings set to '\" + section + \"' '\" + lang + \"'\");\n}\n\n"
-              << "function SetUsbFilter()\n{\n"
-              << "    UsbFilterToggled = document.getElementById(\"SetUsbFilterfilterToggled\");\n"
-              << "    if (!UsbFilterToggled)\n        return;\n"
-              << "    filter = UsbFilterToggled.checked ?\n"
-              << "        document.getElementById(\"SetUsbFilterfilter\").value : \"\";\n"
-              << "    embed.SetUsbFilter(filter);\n"
-              << "    log(\"USB Filter String set to: '\" + filter + \"'\");\n}\n\n"
-              << "function show()\n{\n"
-              << "    embed.show();\n"
-              << "    log(\"Show\");\n}\n\n"
-              << "function ConnectedStatus()\n{\n"
-              << "    log(\"Connected status = \" + embed.ConnectedStatus());\n}\n\n"
-              << "function toggle(checkboxID)\n{\n"
-              << "    var checkbox = document.getElementById(checkboxID);\n"
-              << "    var toggle = document.getElementById(arguments[1]);\n"
-              << "    toggle.disabled = !checkbox.checked;\n}\n\n";
+    m_output << "<html>\n"
+             << "<head>\n"
+             << "<title>Spice-XPI test page (generated)</title>\n"
+             << "<style type=\"text/css\">\n"
+             << "caption {\n"
+             << "    text-align: left;\n"
+             << "    font-weight: bold;\n"
+             << "}\n\n"
+             << "th {\n"
+             << "    text-align: left;\n"
+             << "}\n"
+             << "</style>\n"
+             << "</head>\n\n"
+             << "<body onload=\"bodyLoad()\" onunload=\"bodyUnload()\">\n\n"
+             << "<center>\n"
+             << "<h1>SPICE xpi test page (generated)</h1>\n"
+             << "This page was autogenerated using IDL description and should not be modified by hand.<br>\n"
+             << "Disabled (greyed out) values are passed\n"
+             << "to SPICE xpi as empty variables.\n</center>\n<br/>\n\n"
+             << "<embed type=\"application/x-spice\" width=\"0\" height=\"0\" id=\"spice-xpi\"/><br/>\n\n"
+             << "<script type=\"text/javascript\">\n\n"
+             << "var embed = document.getElementById(\"spice-xpi\");\n\n"
+             << "function bodyLoad()\n{\n    log(\"Body Load\");\n};\n\n"
+             << "function bodyUnload()\n{\n    log(\"Body Unload\");\n}\n\n"
+             << "function connect()\n{\n"
+             << "    setConnectVars();\n"
+             << "    SetUsbFilter();\n"
+             << "    embed.connect();\n"
+             << "    log(\"Connect: host '\" + embed.hostIP + \"', port '\" + "
+             << "embed.port\n        + \"', secure port '\" + embed.SecurePort + "
+             << "\"', USB port '\" +\n        embed.UsbListenPort + \"'\");\n}\n\n"
+             << "function disconnect()\n{\n"
+             << "    embed.disconnect();\n"
+             << "    log(\"Disconnect\");\n}\n\n";
+    // older plugins have no reconnect()
+    if (hasMethod("reconnect"))
+        m_output << "function reconnect()\n{\n"
+                 << "    setConnectVars();\n"
+                 << "    embed.reconnect();\n"
+                 << "    log(\"Reconnect: host '\" + embed.hostIP + \"', port '\" + "
+                 << "embed.port\n        + \"', secure port '\" + embed.SecurePort + \"'\");\n}\n\n";
+    m_output << "function OnDisconnected(msg)\n{\n    log(\"Disconnected, return code: \" + msg);\n}\n\n"
+             << "function log(message)\n{\n"
+             << "    var log = document.getElementById(\"log\");\n"
+             << "    var ts = new Date().toString() + \": \";\n"
+             << "    var newRow = document.createElement(\"tr\");\n"
+             << "    var tsCell = document.createElement(\"td\");\n"
+             << "    var msgCell = document.createElement(\"td\");\n\n"
+             << "    tsCell.innerHTML = ts;\n"
+             << "    msgCell.innerHTML = message;\n\n"
+             << "    newRow.appendChild(tsCell);\n"
+             << "    newRow.appendChild(msgCell);\n"
+             << "    log.insertBefore(newRow, log.firstChild);\n}\n\n"
+             << "function setLanguageStrings()\n{\n"
+             << "    section = document.getElementById(\"SetLanguageStringssectionToggled\").checked ?\n"
+             << "        document.getElementById(\"SetLanguageStringssection\").value : \"\";\n"
+             << "    lang = document.getElementById(\"SetLanguageStringslangToggled\").checked ?\n"
+             << "        document.getElementById(\"SetLanguageStringslang\").value : \"\";\n"
+             << "    embed.SetLanguageStrings(section, lang);\n"
+             << "    log(\"Language Strings set to '\" + section + \"' '\" + lang + \"'\");\n}\n\n"
+             << "function SetUsbFilter()\n{\n"
+             << "    UsbFilterToggled = document.getElementById(\"SetUsbFilterfilterToggled\");\n"
+             << "    if (!UsbFilterToggled)\n        return;\n"
+             << "    filter = UsbFilterToggled.checked ?\n"
+             << "        document.getElementById(\"SetUsbFilterfilter\").value : \"\";\n"
+             << "    embed.SetUsbFilter(filter);\n"
+             << "    log(\"USB Filter String set to: '\" + filter + \"'\");\n}\n\n"
+             << "function show()\n{\n"
+             << "    embed.show();\n"
+             << "    log(\"Show\");\n}\n\n"
+             << "function ConnectedStatus()\n{\n"
+             << "    log(\"Connected status = \" + embed.ConnectedStatus());\n}\n\n"
+             << "function toggle(checkboxID)\n{\n"
+             << "    var checkbox = document.getElementById(checkboxID);\n"
+             << "    var toggle = document.getElementById(arguments[1]);\n"
+             << "    toggle.disabled = !checkbox.checked;\n}\n\n";
 }
 
 void Generator::generateFooter()
 {
-    std::cout << "<hr/>\n<table style=\"border: 1px; border-color: black;\">\n"
-              << "<caption>log:</caption>\n"
-              << "<thead><tr><th style=\"width: 22em;\">timestamp</th>"
-              << "<th>message</th></tr></thead>\n"
-              << "<tbody style=\"font-family: monospace;\" id=\"log\">\n"
-              << "</tbody>\n"
-              << "</table>\n"
-              << "</body>\n"
-              << "</html>\n";
+    m_output << "<hr/>\n<table style=\"border: 1px; border-color: black;\">\n"
+             << "<caption>log:</caption>\n"
+             << "<thead><tr><th style=\"width: 22em;\">timestamp</th>"
+             << "<th>message</th></tr></thead>\n"
+             << "<tbody style=\"font-family: monospace;\" id=\"log\">\n"
+             << "</tbody>\n"
+             << "</table>\n"
+             << "</body>\n"
+             << "</html>\n";
 }
 
 void Generator::generateConnectVars()
 {
-    std::cout << "function setConnectVars()\n{\n";
-    std::list<Attribute>::iterator it;
+    m_output << "function setConnectVars()\n{\n";
+    std::vector<Attribute>::const_iterator it;
     for (it = m_attributes.begin(); it != m_attributes.end(); ++it) {
-        std::cout << "    embed." << it->getIdentifier() << " = "
-                  << "document.getElementById(\""
-                  << it->getIdentifier() << "Toggled\").checked ? ";
+        if (it->isReadonly())
+            continue;
+        m_output << "    embed." << it->getIdentifier() << " = "
+                 << "document.getElementById(\""
+                 << it->getIdentifier() << "Toggled\").checked ? ";
         bool generated_cast = generateConnectVarsParse(*it);
-        std::cout << "document.getElementById(\""
-                  << it->getIdentifier() << "\")."
-                  << (it->getType() == Token::T_BOOLEAN ? "checked" : "value");
+        m_output << "document.getElementById(\""
+                 << it->getIdentifier() << "\")."
+                 << (it->getType() == Token::T_BOOLEAN ? "checked" : "value");
         if (generated_cast)
-            std::cout << ")";
-        std::cout << " : \"\";\n";
+            m_output << ")";
+        m_output << " : \"\";\n";
     }
-    std::cout << "}\n\n</script>\n\n";
+    m_output << "}\n\n</script>\n\n";
 }
 
 void Generator::generateContent()
 {
-    std::cout << "<center>\n\n"
-              << "<table id=\"values\">\n";
+    m_output << "<center>\n\n"
+             << "<table id=\"values\">\n";
 
-    std::list<Attribute>::iterator ita;
+    std::vector<Attribute>::const_iterator ita;
     for (ita = m_attributes.begin(); ita != m_attributes.end(); ++ita) {
-        std::cout << "<tr>\n<td><input type=\"checkbox\" id=\""
-                  << ita->getIdentifier() << "Toggled"
-                  << "\" onclick=\"toggle('"
-                  << ita->getIdentifier() << "Toggled"
-                  <<"', '" << ita->getIdentifier()
-                  << "')\" " << (attributeEnabled(*ita) ? "checked" : "")
-                  << "/></td>\n"
-                  << "<td>" << splitIdentifier(ita->getIdentifier()) << "</td>\n"
-                  << "<td>" << attributeToHtmlElement(*ita)
-                  << "</td>\n</tr>\n";
+        if (ita->isReadonly())
+            continue;
+        m_output << "<tr>\n<td><input type=\"checkbox\" id=\""
+                 << ita->getIdentifier() << "Toggled"
+                 << "\" onclick=\"toggle('"
+                 << ita->getIdentifier() << "Toggled"
+                 <<"', '" << ita->getIdentifier()
+                 << "')\" " << (attributeEnabled(*ita) ? "checked" : "")
+                 << "/></td>\n"
+                 << "<td>" << splitIdentifier(ita->getIdentifier()) << "</td>\n"
+                 << "<td>" << attributeToHtmlElement(*ita)
+                 << "</td>\n</tr>\n";
     }
 
-    std::list<Method>::iterator itm;
+    std::vector<Method>::const_iterator itm;
     for (itm = m_methods.begin(); itm != m_methods.end(); ++itm) {
-        std::list<Method::MethodParam>::iterator itp;
-        std::list<Method::MethodParam> params = itm->getParams();
-        for (itp = params.begin(); itp != params.end(); ++itp) {
-            std::cout << "<tr>\n<td><input type=\"checkbox\" id=\""
-                      << itm->getIdentifier() << itp->getIdentifier()
-                      << "Toggled\" onclick=\"toggle('"
-                      << itm->getIdentifier() << itp->getIdentifier()
-                      << "Toggled', '" << itm->getIdentifier()
-                      << itp->getIdentifier() << "')\""
-                      << (methodEnabled(*itm, *itp) ? " checked" : "")
-                      << "/></td>\n<td>" << splitIdentifier(itm->getIdentifier())
-                      << " - " << splitIdentifier(itp->getIdentifier()) << "</td>\n"
-                      << "<td><input id=\"" << itm->getIdentifier() << itp->getIdentifier()
-                      << "\" type=\"" << (itp->getType() == Token::T_BOOLEAN ? "checkbox" : "text")
-                      << "\" size=\"30\" " << (methodEnabled(*itm, *itp) ? "" : "disabled ")
-                      << "/></td>\n</tr>\n";
+        Method::ParamIterator itp;
+        for (itp = itm->paramsBegin(); itp != itm->paramsEnd(); ++itp) {
+            m_output << "<tr>\n<td><input type=\"checkbox\" id=\""
+                     << itm->getIdentifier() << itp->getIdentifier()
+                     << "Toggled\" onclick=\"toggle('"
+                     << itm->getIdentifier() << itp->getIdentifier()
+                     << "Toggled', '" << itm->getIdentifier()
+                     << itp->getIdentifier() << "')\""
+                     << (methodEnabled(*itm, *itp) ? " checked" : "")
+                     << "/></td>\n<td>" << splitIdentifier(itm->getIdentifier())
+                     << " - " << splitIdentifier(itp->getIdentifier()) << "</td>\n"
+                     << "<td><input id=\"" << itm->getIdentifier() << itp->getIdentifier()
+                     << "\" type=\"" << (itp->getType() == Token::T_BOOLEAN ? "checkbox" : "text")
+                     << "\" size=\"30\" " << (methodEnabled(*itm, *itp) ? "" : "disabled ")
+                     << "/></td>\n</tr>\n";
         }
     }
 
-    std::cout << "</table>\n\n<br/>\n";
+    m_output << "</table>\n\n<br/>\n";
 
     int i = 1;
     for (itm = m_methods.begin(); itm != m_methods.end(); ++itm, ++i) {
-        std::cout << "<input type=\"button\" value=\""
-                  << splitIdentifier(itm->getIdentifier())
-                  << "\" style=\"min-width: 180px\" onclick=\""
-                  << itm->getIdentifier()
-                  << "()\"/>\n";
+        m_output << "<input type=\"button\" value=\""
+                 << splitIdentifier(itm->getIdentifier())
+                 << "\" style=\"min-width: 180px\" onclick=\""
+                 << itm->getIdentifier()
+                 << "()\"/>\n";
         if (i % 3 == 0 && i != static_cast<int>(m_methods.size()))
-            std::cout << "<br/>\n";
+            m_output << "<br/>\n";
     }
 
-    std::cout << "\n</center>\n\n";
+    m_output << "\n</center>\n\n";
+}
+
+bool Generator::hasMethod(const std::string &identifier) const
+{
+    std::vector<Method>::const_iterator it;
+    for (it = m_methods.begin(); it != m_methods.end(); ++it) {
+        if (it->getIdentifier() == identifier)
+            return true;
+    }
+    return false;
 }
 
 std::string Generator::lowerString(const std::string &str)
@@ -265,22 +334,26 @@ std::string Generator::attributeToHtmlElement(const Attribute &attr)
 
 std::string Generator::attributeDefaultValue(const Attribute &attr)
 {
-    std::string id(lowerString(attr.getIdentifier()));
-    std::map<std::string, std::string>::iterator found = s_default_attribute_values.find(id);
-    return found != s_default_attribute_values.end() ? found->second : "";
+    std::string value;
+    if (!defaultAttributeValue(attr, value))
+        return "";
+
+    if (attr.getType() == Token::T_BOOLEAN)
+        return value == "true" ? "checked " : "";
+    return "value=\"" + value + "\" ";
 }
 
 bool Generator::attributeEnabled(const Attribute &attr)
 {
     std::string id(lowerString(attr.getIdentifier()));
-    std::set<std::string>::iterator found = s_default_attributes.find(id);
+    std::set<std::string>::const_iterator found = s_default_attributes.find(id);
     return found != s_default_attributes.end();
 }
 
 bool Generator::methodEnabled(const Method &method, const Method::MethodParam &param)
 {
     std::string id(lowerString(method.getIdentifier() + param.getIdentifier()));
-    std::set<std::string>::iterator found = s_default_methods.find(id);
+    std::set<std::string>::const_iterator found = s_default_methods.find(id);
     return found != s_default_methods.end();
 }
 
@@ -289,7 +362,7 @@ bool Generator::generateConnectVarsParse(const Attribute &attr)
     switch (attr.getType()) {
     case Token::T_FLOAT:
     case Token::T_DOUBLE:
-        std::cout << "parseFloat(";
+        m_output << "parseFloat(";
         return true;
     case Token::T_UNSIGNED:
     case Token::T_SHORT:
@@ -300,7 +373,7 @@ bool Generator::generateConnectVarsParse(const Attribute &attr)
     case Token::T_UNSIGNED_SHORT:
     case Token::T_UNSIGNED_LONG:
     case Token::T_UNSIGNED_LONG_LONG:
-        std::cout << "parseInt(";
+        m_output << "parseInt(";
         return true;
     }
 
@@ -18,28 +18,34 @@
 #ifndef GENERATOR_H
 #define GENERATOR_H
 
-#include <list>
 #include <map>
 #include <set>
+#include <vector>
 #include "attribute.h"
 #include "method.h"
+#include "outputbuffer.h"
 #include "token.h"
 
 class Generator
 {
 public:
-    Generator(const std::list<Attribute> &attributes,
-              const std::list<Method> &methods);
+    Generator(const std::vector<Attribute> &attributes,
+              const std::vector<Method> &methods);
     ~Generator();
 
-    void generate();
+    // writes the page to std::cout at once
+    bool generate();
+
+    // default value of the attribute on the test page, as a string
+    static bool defaultAttributeValue(const Attribute &attr, std::string &value);
 
 private:
-    void init();
+    size_t estimateSize() const;
     void generateHeader();
     void generateFooter();
     void generateConnectVars();
     void generateContent();
+    bool hasMethod(const std::string &identifier) const;
 
     static std::string lowerString(const std::string &str);
     static std::string splitIdentifier(const std::string &str);
@@ -47,14 +53,15 @@ private:
     static std::string attributeToHtmlElement(const Attribute &attr);
     static bool attributeEnabled(const Attribute &attr);
     static bool methodEnabled(const Method &method, const Method::MethodParam &param);
-    static bool generateConnectVarsParse(const Attribute &attr);
+    bool generateConnectVarsParse(const Attribute &attr);
 
 private:
-    std::list<Attribute> m_attributes;
-    std::list<Method> m_methods;
-    static std::set<std::string> s_default_attributes;
-    static std::set<std::string> s_default_methods;
-    static std::map<std::string, std::string> s_default_attribute_values;
+    const std::vector<Attribute> &m_attributes;
+    const std::vector<Method> &m_methods;
+    OutputBuffer m_output;
+    static const std::set<std::string> s_default_attributes;
+    static const std::set<std::string> s_default_methods;
+    static const std::map<std::string, std::string> s_default_attribute_values;
 };
 
 #endif // GENERATOR_H
@@ -0,0 +1,265 @@
+/* ***** BEGIN LICENSE BLOCK *****
+*   Copyright (C) 2026, Red Hat Inc.
+*
+*   This program is free software; you can redistribute it and/or
+*   modify it under the terms of the GNU General Public License as
+*   published by the Free Software Foundation; either version 2 of
+*   the License, or (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program. If not, see <http://www.gnu.org/licenses/>.
+* ***** END LICENSE BLOCK ***** */
+
+#include <iostream>
+#include <sstream>
+#include <cstdlib>
+extern "C" {
+#  include <pthread.h>
+}
+#include "includegraph.h"
+
+namespace {
+
+std::string dir_name(const std::string &path)
+{
+    std::string::size_type slash = path.rfind('/');
+    if (slash == std::string::npos)
+        return ".";
+    if (slash == 0)
+        return "/";
+    return path.substr(0, slash);
+}
+
+// empty string, if the file does not exist
+std::string canonical_path(const std::string &path)
+{
+    char *real = realpath(path.c_str(), NULL);
+    if (!real)
+        return std::string();
+    std::string result(real);
+    free(real);
+    return result;
+}
+
+} // unnamed namespace
+
+struct IncludeGraph::ParseQueue
+{
+    std::vector<File *> *files;
+    size_t next;
+    pthread_mutex_t lock;
+};
+
+IncludeGraph::IncludeGraph(const std::vector<std::string> &include_paths, unsigned int jobs):
+    m_include_paths(include_paths),
+    m_jobs(jobs),
+    m_visited(),
+    m_files()
+{
+}
+
+IncludeGraph::~IncludeGraph()
+{
+    std::vector<File *>::iterator it;
+    for (it = m_files.begin(); it != m_files.end(); ++it) {
+        delete (*it)->parser;
+        delete *it;
+    }
+}
+
+void IncludeGraph::load(const Parser &parser, const std::string &filename)
+{
+    std::string dir(".");
+    if (!filename.empty()) {
+        m_visited.insert(canonical_path(filename));
+        dir = dir_name(filename);
+    }
+
+    std::vector<File *> level;
+    addIncludes(parser, dir, level);
+    while (!level.empty()) {
+        parseLevel(level);
+
+        std::vector<File *> next;
+        std::vector<File *>::const_iterator it;
+        for (it = level.begin(); it != level.end(); ++it) {
+            if ((*it)->good)
+                addIncludes(*(*it)->parser, dir_name((*it)->path), next);
+        }
+        level.swap(next);
+    }
+}
+
+std::string IncludeGraph::resolve(const Parser::Include &include, const std::string &dir) const
+{
+    std::string path;
+    if (include.quoted) {
+        path = canonical_path(dir + "/" + include.name);
+        if (!path.empty())
+            return path;
+    }
+
+    std::vector<std::string>::const_iterator it;
+    for (it = m_include_paths.begin(); it != m_include_paths.end(); ++it) {
+        path = canonical_path(*it + "/" + include.name);
+        if (!path.empty())
+            return path;
+    }
+    return path;
+}
+
+void IncludeGraph::addIncludes(const Parser &parser, const std::string &dir,
+                               std::vector<File *> &level)
+{
+    const std::vector<Parser::Include> &includes = parser.getIncludes();
+    std::vector<Parser::Include>::const_iterator it;
+    for (it = includes.begin(); it != includes.end(); ++it) {
+        std::string path = resolve(*it, dir);
+        if (path.empty()) {
+            // without any include path, keep quiet like the generator
+            // always did for the single IDL file
+            if (!m_include_paths.empty())
+                std::cerr << "Warning: include file '" << it->name << "' not found\n";
+            continue;
+        }
+
+        if (!m_visited.insert(path).second)
+            continue;
+
+        File *file = new File(path);
+        m_files.push_back(file);
+        level.push_back(file);
+    }
+}
+
+void IncludeGraph::parseLevel(std::vector<File *> &level)
+{
+    unsigned int threads = m_jobs;
+    if (threads > level.size())
+        threads = level.size();
+
+    ParseQueue queue;
+    queue.files = &level;
+    queue.next = 0;
+    pthread_mutex_init(&queue.lock, NULL);
+
+    // the calling thread is one of the workers
+    std::vector<pthread_t> workers;
+    for (unsigned int i = 1; i < threads; ++i) {
+        pthread_t worker;
+        if (pthread_create(&worker, NULL, parseWorker, &queue) != 0)
+            break;
+        workers.push_back(worker);
+    }
+    parseWorker(&queue);
+
+    std::vector<pthread_t>::iterator it;
+    for (it = workers.begin(); it != workers.end(); ++it)
+        pthread_join(*it, NULL);
+    pthread_mutex_destroy(&queue.lock);
+}
+
+void *IncludeGraph::parseWorker(void *data)
+{
+    ParseQueue *queue = static_cast<ParseQueue *>(data);
+    while (1) {
+        pthread_mutex_lock(&queue->lock);
+        size_t index = queue->next++;
+        pthread_mutex_unlock(&queue->lock);
+
+        if (index >= queue->files->size())
+            return NULL;
+        parseFile((*queue->files)[index]);
+    }
+}
+
+void IncludeGraph::parseFile(File *file)
+{
+    if (!file->input.open(file->path))
+        return;
+
+    file->parser = new Parser(file->input, file->path);
+    file->good = file->parser->parse();
+    if (!file->good) {
+        // called by the worker threads, write the whole line at once
+        std::ostringstream msg;
+        msg << "Warning: ignoring the declarations of '" << file->path << "'\n";
+        std::cerr << msg.str();
+    }
+}
+
+void IncludeGraph::stamp(Stamp &stamp) const
+{
+    std::vector<File *>::const_iterator it;
+    for (it = m_files.begin(); it != m_files.end(); ++it)
+        stamp.addFile((*it)->path, (*it)->input);
+}
+
+void IncludeGraph::stats(Stats &stats) const
+{
+    std::vector<File *>::const_iterator it;
+    for (it = m_files.begin(); it != m_files.end(); ++it) {
+        if ((*it)->parser)
+            stats.addFile((*it)->input, *(*it)->parser);
+    }
+}
+
+const Interface *IncludeGraph::findInterface(const Parser &parser,
+                                             const std::string &identifier) const
+{
+    const std::vector<Interface> &local = parser.getInterfaces();
+    std::vector<Interface>::const_iterator iface;
+    for (iface = local.begin(); iface != local.end(); ++iface) {
+        if (iface->getIdentifier() == identifier)
+            return &*iface;
+    }
+
+    // files closer to the main IDL come first
+    std::vector<File *>::const_iterator it;
+    for (it = m_files.begin(); it != m_files.end(); ++it) {
+        if (!(*it)->good)
+            continue;
+        const std::vector<Interface> &ifaces = (*it)->parser->getInterfaces();
+        for (iface = ifaces.begin(); iface != ifaces.end(); ++iface) {
+            if (iface->getIdentifier() == identifier)
+                return &*iface;
+        }
+    }
+    return NULL;
+}
+
+void IncludeGraph::flatten(const Parser &parser,
+                           std::vector<Attribute> &attributes,
+                           std::vector<Method> &methods) const
+{
+    std::set<std::string> visited;
+    const std::vector<Interface> &ifaces = parser.getInterfaces();
+    std::vector<Interface>::const_iterator it;
+    for (it = ifaces.begin(); it != ifaces.end(); ++it)
+        flattenInterface(parser, *it, attributes, methods, visited);
+}
+
+void IncludeGraph::flattenInterface(const Parser &parser,
+                                    const Interface &iface,
+                                    std::vector<Attribute> &attributes,
+                                    std::vector<Method> &methods,
+                                    std::set<std::string> &visited) const
+{
+    if (!visited.insert(iface.getIdentifier()).second)
+        return;
+
+    Interface::BaseIterator base;
+    for (base = iface.basesBegin(); base != iface.basesEnd(); ++base) {
+        const Interface *base_iface = findInterface(parser, **base);
+        if (base_iface)
+            flattenInterface(parser, *base_iface, attributes, methods, visited);
+    }
+
+    attributes.insert(attributes.end(), iface.attributesBegin(), iface.attributesEnd());
+    methods.insert(methods.end(), iface.methodsBegin(), iface.methodsEnd());
+}
@@ -0,0 +1,104 @@
+/* ***** BEGIN LICENSE BLOCK *****
+*   Copyright (C) 2026, Red Hat Inc.
+*
+*   This program is free software; you can redistribute it and/or
+*   modify it under the terms of the GNU General Public License as
+*   published by the Free Software Foundation; either version 2 of
+*   the License, or (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program. If not, see <http://www.gnu.org/licenses/>.
+* ***** END LICENSE BLOCK ***** */
+
+#ifndef INCLUDEGRAPH_H
+#define INCLUDEGRAPH_H
+
+#include <set>
+#include <string>
+#include <vector>
+#include "attribute.h"
+#include "interface.h"
+#include "method.h"
+#include "parser.h"
+#include "scannerinput.h"
+#include "stamp.h"
+#include "stats.h"
+
+// Files reachable through the #include directives of the main IDL. Every
+// file is parsed once, however many times it is included, which also
+// breaks include cycles. The graph is walked level by level; the files of
+// one level do not depend on each other and are parsed by a pool of
+// threads.
+//
+// An included file, which can not be parsed with the restricted grammar
+// of the generator (e.g. a libxul IDL with native types or C++ blocks),
+// is reported and its interfaces are treated as unknown.
+class IncludeGraph
+{
+public:
+    IncludeGraph(const std::vector<std::string> &include_paths, unsigned int jobs);
+    ~IncludeGraph();
+
+    // filename is empty, if the main IDL was read from stdin
+    void load(const Parser &parser, const std::string &filename);
+
+    // members of the parser's interfaces, preceded by the members of their
+    // base interfaces; a base which was not found contributes nothing
+    void flatten(const Parser &parser,
+                 std::vector<Attribute> &attributes,
+                 std::vector<Method> &methods) const;
+
+    // adds every included file to the stamp of the output
+    void stamp(Stamp &stamp) const;
+
+    // adds every parsed included file to the stats
+    void stats(Stats &stats) const;
+
+private:
+    struct File
+    {
+        File(const std::string &path):
+            path(path),
+            input(),
+            parser(NULL),
+            good(false)
+        {}
+
+        std::string path;
+        ScannerInput input;
+        Parser *parser;
+        bool good;
+    };
+
+    struct ParseQueue;
+
+    IncludeGraph(const IncludeGraph &copy);
+    IncludeGraph &operator=(const IncludeGraph &rhs);
+
+    std::string resolve(const Parser::Include &include, const std::string &dir) const;
+    void addIncludes(const Parser &parser, const std::string &dir,
+                     std::vector<File *> &level);
+    void parseLevel(std::vector<File *> &level);
+    static void *parseWorker(void *data);
+    static void parseFile(File *file);
+
+    const Interface *findInterface(const Parser &parser, const std::string &identifier) const;
+    void flattenInterface(const Parser &parser,
+                          const Interface &iface,
+                          std::vector<Attribute> &attributes,
+                          std::vector<Method> &methods,
+                          std::set<std::string> &visited) const;
+
+private:
+    const std::vector<std::string> m_include_paths;
+    const unsigned int m_jobs;
+    std::set<std::string> m_visited;
+    std::vector<File *> m_files;
+};
+
+#endif // INCLUDEGRAPH_H
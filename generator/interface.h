@@ -0,0 +1,80 @@
+/* ***** BEGIN LICENSE BLOCK *****
+*   Copyright (C) 2026, Red Hat Inc.
+*
+*   This program is free software; you can redistribute it and/or
+*   modify it under the terms of the GNU General Public License as
+*   published by the Free Software Foundation; either version 2 of
+*   the License, or (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program. If not, see <http://www.gnu.org/licenses/>.
+* ***** END LICENSE BLOCK ***** */
+
+#ifndef INTERFACE_H
+#define INTERFACE_H
+
+#include <string>
+#include <vector>
+#include "attribute.h"
+#include "method.h"
+
+// An interface refers to its slice of the attributes and methods owned by
+// the parser, like a method does with its parameters. Base interfaces are
+// kept by name; they may live in another (included) file.
+class Interface
+{
+public:
+    typedef std::vector<const std::string *> BaseList;
+    typedef BaseList::const_iterator BaseIterator;
+    typedef std::vector<Attribute>::const_iterator AttributeIterator;
+    typedef std::vector<Method>::const_iterator MethodIterator;
+
+public:
+    // identifier is an interned string, see InternTable
+    Interface(const std::string &identifier,
+              const std::vector<Attribute> &attributes,
+              const std::vector<Method> &methods):
+        m_identifier(&identifier),
+        m_bases(),
+        m_attributes(&attributes),
+        m_first_attribute(attributes.size()),
+        m_attribute_count(0),
+        m_methods(&methods),
+        m_first_method(methods.size()),
+        m_method_count(0)
+    {}
+
+    // closes the member slices at the current end of the parser's vectors
+    void finish()
+    {
+        m_attribute_count = m_attributes->size() - m_first_attribute;
+        m_method_count = m_methods->size() - m_first_method;
+    }
+
+    void addBase(const std::string &identifier) { m_bases.push_back(&identifier); }
+
+    const std::string &getIdentifier() const { return *m_identifier; }
+    BaseIterator basesBegin() const { return m_bases.begin(); }
+    BaseIterator basesEnd() const { return m_bases.end(); }
+    AttributeIterator attributesBegin() const { return m_attributes->begin() + m_first_attribute; }
+    AttributeIterator attributesEnd() const { return attributesBegin() + m_attribute_count; }
+    MethodIterator methodsBegin() const { return m_methods->begin() + m_first_method; }
+    MethodIterator methodsEnd() const { return methodsBegin() + m_method_count; }
+
+private:
+    const std::string *m_identifier;
+    BaseList m_bases;
+    const std::vector<Attribute> *m_attributes;
+    size_t m_first_attribute;
+    size_t m_attribute_count;
+    const std::vector<Method> *m_methods;
+    size_t m_first_method;
+    size_t m_method_count;
+};
+
+#endif // INTERFACE_H
@@ -0,0 +1,93 @@
+/* ***** BEGIN LICENSE BLOCK *****
+*   Copyright (C) 2026, Red Hat Inc.
+*
+*   This program is free software; you can redistribute it and/or
+*   modify it under the terms of the GNU General Public License as
+*   published by the Free Software Foundation; either version 2 of
+*   the License, or (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program. If not, see <http://www.gnu.org/licenses/>.
+* ***** END LICENSE BLOCK ***** */
+
+#ifndef INTERNTABLE_H
+#define INTERNTABLE_H
+
+#include <cstring>
+#include <deque>
+#include <string>
+#include <vector>
+
+// Every identifier of the parsed IDL is stored once; the AST refers to
+// the stored strings, which stay at the same address for the lifetime
+// of the table. Lookups go through an open addressing hash table, so
+// only the first occurrence of an identifier allocates.
+class InternTable
+{
+public:
+    InternTable():
+        m_strings(),
+        m_slots(64, static_cast<const std::string *>(NULL))
+    {}
+
+    ~InternTable()
+    {}
+
+    const std::string &intern(const char *str, size_t len)
+    {
+        size_t slot = find(m_slots, str, len);
+        if (m_slots[slot] != NULL)
+            return *m_slots[slot];
+
+        m_strings.push_back(std::string(str, len));
+        m_slots[slot] = &m_strings.back();
+        if (m_strings.size() * 2 > m_slots.size())
+            grow();
+        return m_strings.back();
+    }
+
+    size_t size() const { return m_strings.size(); }
+
+private:
+    static size_t hash(const char *str, size_t len)
+    {
+        // FNV-1a
+        size_t h = 2166136261u;
+        for (size_t i = 0; i < len; ++i)
+            h = (h ^ static_cast<unsigned char>(str[i])) * 16777619u;
+        return h;
+    }
+
+    static size_t find(const std::vector<const std::string *> &slots,
+                       const char *str, size_t len)
+    {
+        const size_t mask = slots.size() - 1;
+        size_t slot = hash(str, len) & mask;
+        while (slots[slot] != NULL &&
+               (slots[slot]->size() != len ||
+                memcmp(slots[slot]->data(), str, len) != 0))
+            slot = (slot + 1) & mask;
+        return slot;
+    }
+
+    void grow()
+    {
+        std::vector<const std::string *> slots(m_slots.size() * 2,
+            static_cast<const std::string *>(NULL));
+        std::deque<std::string>::const_iterator it;
+        for (it = m_strings.begin(); it != m_strings.end(); ++it)
+            slots[find(slots, it->data(), it->size())] = &*it;
+        m_slots.swap(slots);
+    }
+
+private:
+    std::deque<std::string> m_strings;
+    std::vector<const std::string *> m_slots;
+};
+
+#endif // INTERNTABLE_H
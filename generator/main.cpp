@@ -15,10 +15,19 @@
 *   along with this program. If not, see <http://www.gnu.org/licenses/>.
 * ***** END LICENSE BLOCK ***** */
 
+#include <iostream>
+#include <vector>
+#include "benchmarkgenerator.h"
+#include "controllergenerator.h"
 #include "generator.h"
+#include "includegraph.h"
 #include "options.h"
 #include "parser.h"
 #include "redirecthelper.h"
+#include "scannerinput.h"
+#include "schemagenerator.h"
+#include "stamp.h"
+#include "stats.h"
 
 int main(int argc, char **argv)
 {
@@ -31,17 +40,67 @@ int main(int argc, char **argv)
         return 0;
     }
 
+    Stamp stamp(o);
+    if (!o.force() && stamp.upToDate()) {
+        stamp.touch();
+        return 0;
+    }
+
+    // invalid until the new output is complete
+    stamp.remove();
+
+    ScannerInput input;
+    if (o.inputFilename().empty() ? !input.readStdin() : !input.open(o.inputFilename()))
+        return 1;
+
     RedirectHelper rh(o);
     if (!rh.redirect())
         return 1;
 
-    Parser p;
+    Stats stats;
+    stats.startParse();
+    Parser p(input);
     if (!p.parse())
         return 1;
 
-    Generator g(p.getAttributes(), p.getMethods());
-    g.generate();
+    IncludeGraph includes(o.includePaths(), o.jobs());
+    includes.load(p, o.inputFilename());
+    stats.stopParse();
+    if (o.stats()) {
+        stats.addFile(input, p);
+        includes.stats(stats);
+        stats.print();
+    }
+
+    stamp.addFile(o.inputFilename(), input);
+    includes.stamp(stamp);
+
+    std::vector<Attribute> attributes;
+    std::vector<Method> methods;
+    includes.flatten(p, attributes, methods);
+
+    bool written;
+    if (o.mode() == Options::MODE_CONTROLLER) {
+        ControllerGenerator g(attributes);
+        written = g.generate();
+    } else if (o.mode() == Options::MODE_BENCHMARK) {
+        BenchmarkGenerator g(attributes, methods);
+        written = g.generate();
+    } else if (o.mode() == Options::MODE_SCHEMA_JSON || o.mode() == Options::MODE_SCHEMA_CPP) {
+        SchemaGenerator g(attributes, o.mode() == Options::MODE_SCHEMA_CPP ?
+            SchemaGenerator::FORMAT_CPP : SchemaGenerator::FORMAT_JSON);
+        written = g.generate();
+    } else {
+        Generator g(attributes, methods);
+        written = g.generate();
+    }
+
+    if (!written) {
+        std::cerr << "Unable to write the generated output!\n";
+        return 1;
+    }
 
     rh.restore();
+    stamp.save();
     return 0;
 }
@@ -0,0 +1,58 @@
+#!/bin/sh
+#
+# Writes a synthetic IDL corpus to stdout, to benchmark the scanner and
+# the parser of the generator on large inputs:
+#
+#   ./make-corpus.sh 5000 > corpus.idl
+#   ./spice-xpi-generator --stats -i corpus.idl -o /dev/null
+#
+# Usage: make-corpus.sh [interfaces] [attributes] [methods]
+# (per interface; defaults 1000, 20 and 10)
+
+interfaces=${1:-1000}
+attributes=${2:-20}
+methods=${3:-10}
+
+awk -v interfaces="$interfaces" -v attributes="$attributes" -v methods="$methods" '
+BEGIN {
+    ntypes = split("string boolean long short float double octet char " \
+                   "wstring unsigned_long unsigned_short long_long", types, " ")
+    ndirs = split("in out inout", dirs, " ")
+
+    print "/* Synthetic IDL corpus generated by make-corpus.sh */"
+    print ""
+    print "#include \"nsISupports.idl\""
+    print ""
+
+    for (i = 0; i < interfaces; ++i) {
+        printf "/**\n * Interface %d of the corpus.\n *\n", i
+        printf " * Block comments span several lines, like the ones of real IDL.\n */\n"
+        printf "[scriptable, uuid(%08x-%04x-%04x-%04x-%012x)]\n",
+            i, i % 65536, (i * 7) % 65536, (i * 13) % 65536, i * 31
+        if (i > 0 && i % 10 == 0)
+            printf "interface nsICorpus%d : nsICorpus%d {\n", i, i - 1
+        else
+            printf "interface nsICorpus%d : nsISupports {\n", i
+
+        for (j = 0; j < attributes; ++j) {
+            type = types[(i + j) % ntypes + 1]
+            gsub("_", " ", type)
+            if (j % 5 == 0)
+                printf "    // attribute %d of interface %d\n", j, i
+            printf "    %sattribute %s Attr%dValue%d;\n",
+                (j % 7 == 6 ? "readonly " : ""), type, i, j
+        }
+
+        for (j = 0; j < methods; ++j) {
+            printf "    %s Method%dCall%d(", (j % 3 == 0 ? "void" : "long"), i, j
+            for (k = 0; k < j % 4; ++k) {
+                type = types[(i + j + k) % ntypes + 1]
+                gsub("_", " ", type)
+                printf "%s%s %s arg%d", (k ? ", " : ""), dirs[k % ndirs + 1], type, k
+            }
+            printf ");\n"
+        }
+        print "};"
+        print ""
+    }
+}'
@@ -19,82 +19,70 @@
 #define METHOD_H
 
 #include <string>
-#include <list>
+#include <vector>
 #include "token.h"
 
+// The parameters of all the methods are kept in one vector owned by the
+// parser; a method refers to its slice of it.
 class Method
 {
 public:
     class MethodParam;
+    typedef std::vector<MethodParam> ParamArena;
+    typedef ParamArena::const_iterator ParamIterator;
 
 public:
-    Method(Token::TokenType type, std::string &identifier, const std::list<MethodParam> &params):
+    // identifier is an interned string, see InternTable
+    Method(Token::TokenType type, const std::string &identifier,
+           const ParamArena &params, size_t first_param, size_t param_count):
         m_type(type),
-        m_identifier(identifier),
-        m_params(params)
-    {}
-
-    Method(const Method &copy):
-        m_type(copy.m_type),
-        m_identifier(copy.m_identifier),
-        m_params(copy.m_params)
-    {}
-
-    ~Method()
+        m_identifier(&identifier),
+        m_params(&params),
+        m_first_param(first_param),
+        m_param_count(param_count)
     {}
 
     Token::TokenType getType() const { return m_type; }
-    std::string getIdentifier() const { return m_identifier; }
-    std::list<MethodParam> getParams() const { return m_params; }
-
-    Method &operator=(const Method &rhs)
-    {
-        m_type = rhs.m_type;
-        m_identifier = rhs.m_identifier;
-        m_params = rhs.m_params;
-        return *this;
-    }
+    const std::string &getIdentifier() const { return *m_identifier; }
+    inline ParamIterator paramsBegin() const;
+    inline ParamIterator paramsEnd() const;
 
 private:
     Token::TokenType m_type;
-    std::string m_identifier;
-    std::list<MethodParam> m_params;
+    const std::string *m_identifier;
+    const ParamArena *m_params;
+    size_t m_first_param;
+    size_t m_param_count;
 };
 
 class Method::MethodParam
 {
 public:
+    // identifier is an interned string, see InternTable
     MethodParam(Token::TokenType dir, Token::TokenType type, const std::string &identifier):
         m_dir(dir),
         m_type(type),
-        m_identifier(identifier)
-    {}
-
-    MethodParam(const MethodParam &copy):
-        m_dir(copy.m_dir),
-        m_type(copy.m_type),
-        m_identifier(copy.m_identifier)
-    {}
-
-    ~MethodParam()
+        m_identifier(&identifier)
     {}
 
     Token::TokenType getType() const { return m_type; }
     Token::TokenType getDir() const { return m_dir; }
-    std::string getIdentifier() const { return m_identifier; }
-
-    MethodParam &operator=(const MethodParam &rhs)
-    {
-        m_dir = rhs.m_dir;
-        m_type = rhs.m_type;
-        m_identifier = rhs.m_identifier;
-        return *this;
-    }
+    const std::string &getIdentifier() const { return *m_identifier; }
 
 private:
     Token::TokenType m_dir;
     Token::TokenType m_type;
-    std::string m_identifier;
+    const std::string *m_identifier;
 };
 
+Method::ParamIterator Method::paramsBegin() const
+{
+    return m_params->begin() + m_first_param;
+}
+
+Method::ParamIterator Method::paramsEnd() const
+{
+    return m_params->begin() + m_first_param + m_param_count;
+}
+
 #endif // METHOD_H
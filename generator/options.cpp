@@ -16,6 +16,7 @@
 * ***** END LICENSE BLOCK ***** */
 
 #include <iostream>
+#include <cstdlib>
 #include <cstring>
 extern "C" {
 #  include <getopt.h>
@@ -25,19 +26,30 @@ extern "C" {
 Options::Options(int argc, char **argv):
     m_help(false),
     m_good(true),
+    m_force(false),
+    m_stats(false),
     m_input_filename(),
     m_output_filename(),
+    m_include_paths(),
+    m_jobs(1),
+    m_mode(MODE_PAGE),
+    m_mode_name("page"),
     m_bin_name(argv && argv[0] ? basename(argv[0]) : "spice-xpi-generator")
 {
     static struct option longopts[] = {
         { "input",  required_argument, NULL, 'i' },
         { "output", required_argument, NULL, 'o' },
+        { "include", required_argument, NULL, 'I' },
+        { "jobs",   required_argument, NULL, 'j' },
+        { "force",  no_argument,       NULL, 'f' },
+        { "mode",   required_argument, NULL, 'm' },
+        { "stats",  no_argument,       NULL, 's' },
         { "help",   no_argument,       NULL, 'h' },
         { NULL,     0,                 NULL,  0  }
     };
 
     int c;
-    while ((c = getopt_long(argc, argv, "i:o:h", longopts, NULL)) != -1) {
+    while ((c = getopt_long(argc, argv, "i:o:I:j:fm:sh", longopts, NULL)) != -1) {
         switch (c) {
         case 'i':
             m_input_filename = optarg;
@@ -45,6 +57,43 @@ Options::Options(int argc, char **argv):
         case 'o':
             m_output_filename = optarg;
             break;
+        case 'I':
+            m_include_paths.push_back(optarg);
+            break;
+        case 'j': {
+            char *end;
+            long jobs = strtol(optarg, &end, 10);
+            if (*optarg == '\0' || *end != '\0' || jobs < 1) {
+                std::cerr << m_bin_name << ": invalid number of jobs '" << optarg << "'\n";
+                m_good = false;
+                break;
+            }
+            m_jobs = jobs;
+            break;
+        }
+        case 'f':
+            m_force = true;
+            break;
+        case 'm':
+            m_mode_name = optarg;
+            if (m_mode_name == "page") {
+                m_mode = MODE_PAGE;
+            } else if (m_mode_name == "controller") {
+                m_mode = MODE_CONTROLLER;
+            } else if (m_mode_name == "benchmark") {
+                m_mode = MODE_BENCHMARK;
+            } else if (m_mode_name == "schema-json") {
+                m_mode = MODE_SCHEMA_JSON;
+            } else if (m_mode_name == "schema-cpp") {
+                m_mode = MODE_SCHEMA_CPP;
+            } else {
+                std::cerr << m_bin_name << ": unknown mode '" << optarg << "'\n";
+                m_good = false;
+            }
+            break;
+        case 's':
+            m_stats = true;
+            break;
         case 'h':
             m_help = true;
             break;
@@ -62,9 +111,17 @@ Options::~Options()
 void Options::printHelp() const
 {
     std::cout << "Spice-xpi test page generator\n\n"
-              << "Usage: " << m_bin_name << " [-h] [-i input] [-o output]\n\n"
+              << "Usage: " << m_bin_name << " [-h] [-i input] [-o output] [-I dir]... [-j jobs] [-f] [-m mode] [-s]\n\n"
               << "Application options:\n"
               << "  -i, --input     input filename (stdin used, if not specified)\n"
               << "  -o, --output    output filename (stdout used, if not specified)\n"
+              << "  -I, --include   directory searched for included IDL files, may be repeated\n"
+              << "  -j, --jobs      number of threads parsing the included files (default 1)\n"
+              << "  -f, --force     regenerate the output, even if its stamp is up to date\n"
+              << "  -m, --mode      output: page (html test page, default),\n"
+              << "                  controller (C++ header with the controller handshake),\n"
+              << "                  benchmark (html page measuring the plugin calls),\n"
+              << "                  schema-json or schema-cpp (schema of the properties)\n"
+              << "  -s, --stats     prints the scanner and parser throughput to stderr\n"
               << "  -h, --help      prints this help\n";
 }
@@ -19,24 +19,46 @@
 #define OPTIONS_H
 
 #include <string>
+#include <vector>
 
 class Options
 {
+public:
+    enum Mode {
+        MODE_PAGE,          // html test page
+        MODE_CONTROLLER,    // controller handshake header
+        MODE_BENCHMARK,     // html call benchmark page
+        MODE_SCHEMA_JSON,   // property schema, JSON
+        MODE_SCHEMA_CPP     // property schema, C++ header
+    };
+
 public:
     Options(int argc, char **argv);
     ~Options();
 
     bool help() const { return m_help; }
     bool good() const { return m_good; }
+    bool force() const { return m_force; }
+    bool stats() const { return m_stats; }
     void printHelp() const;
     std::string inputFilename() const { return m_input_filename; }
     std::string outputFilename() const { return m_output_filename; }
+    const std::vector<std::string> &includePaths() const { return m_include_paths; }
+    unsigned int jobs() const { return m_jobs; }
+    Mode mode() const { return m_mode; }
+    std::string modeName() const { return m_mode_name; }
 
 private:
     bool m_help;
     bool m_good;
+    bool m_force;
+    bool m_stats;
     std::string m_input_filename;
     std::string m_output_filename;
+    std::vector<std::string> m_include_paths;
+    unsigned int m_jobs;
+    Mode m_mode;
+    std::string m_mode_name;
     const std::string m_bin_name;
 };
 
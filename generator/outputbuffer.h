@@ -0,0 +1,72 @@
+/* ***** BEGIN LICENSE BLOCK *****
+*   Copyright (C) 2026, Red Hat Inc.
+*
+*   This program is free software; you can redistribute it and/or
+*   modify it under the terms of the GNU General Public License as
+*   published by the Free Software Foundation; either version 2 of
+*   the License, or (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program. If not, see <http://www.gnu.org/licenses/>.
+* ***** END LICENSE BLOCK ***** */
+
+#ifndef OUTPUTBUFFER_H
+#define OUTPUTBUFFER_H
+
+#include <iostream>
+#include <string>
+
+// Append-only text buffer; the generated page is assembled in memory and
+// handed to the output stream in a single write.
+class OutputBuffer
+{
+public:
+    OutputBuffer():
+        m_data()
+    {}
+
+    ~OutputBuffer()
+    {}
+
+    void reserve(size_t size) { m_data.reserve(size); }
+    size_t size() const { return m_data.size(); }
+
+    OutputBuffer &operator<<(const std::string &str)
+    {
+        m_data.append(str);
+        return *this;
+    }
+
+    OutputBuffer &operator<<(const char *str)
+    {
+        m_data.append(str);
+        return *this;
+    }
+
+    OutputBuffer &operator<<(char c)
+    {
+        m_data.push_back(c);
+        return *this;
+    }
+
+    bool writeTo(std::ostream &os) const
+    {
+        os.write(m_data.data(), m_data.size());
+        os.flush();
+        return os.good();
+    }
+
+private:
+    OutputBuffer(const OutputBuffer &copy);
+    OutputBuffer &operator=(const OutputBuffer &rhs);
+
+private:
+    std::string m_data;
+};
+
+#endif // OUTPUTBUFFER_H
@@ -16,14 +16,19 @@
 * ***** END LICENSE BLOCK ***** */
 
 #include <iostream>
-#include <list>
+#include <sstream>
 #include "parser.h"
 
-Parser::Parser():
-    m_scanner(),
+Parser::Parser(const ScannerInput &input, const std::string &filename):
+    m_scanner(input),
     m_token(),
+    m_filename(filename),
+    m_names(),
     m_attributes(),
-    m_methods()
+    m_methods(),
+    m_params(),
+    m_interfaces(),
+    m_includes()
 {
 }
 
@@ -52,9 +57,14 @@ bool Parser::parse()
 
 void Parser::handleError() const
 {
-    std::cerr << (m_token == Token::T_LEX_ERROR ?
+    // included files may be parsed in parallel, write the whole line at once
+    std::ostringstream msg;
+    if (!m_filename.empty())
+        msg << m_filename << ": ";
+    msg << (m_token == Token::T_LEX_ERROR ?
         "Lexical error near line: " : "Syntax error near line: ");
-    std::cerr << m_scanner.getLineNo() << std::endl;
+    msg << m_scanner.getLineNo() << std::endl;
+    std::cerr << msg.str();
 }
 
 bool Parser::parseInclude()
@@ -70,24 +80,45 @@ bool Parser::parseInclude()
         return false;
     }
 
+    std::string name;
     m_token = m_scanner.getNextToken();
     if (m_token == Token::T_QUOTE) {
         m_token = m_scanner.getNextToken();
-        while (m_token == Token::T_IDENTIFIER || m_token == Token::T_DOT)
+        while (m_token == Token::T_IDENTIFIER || m_token == Token::T_DOT ||
+               m_token == Token::T_SLASH)
+        {
+            if (m_token == Token::T_DOT)
+                name += '.';
+            else if (m_token == Token::T_SLASH)
+                name += '/';
+            else
+                name.append(m_token.getData(), m_token.getLength());
             m_token = m_scanner.getNextToken();
+        }
         if (m_token != Token::T_QUOTE) {
             handleError();
             return false;
         }
+        m_includes.push_back(Include(name, true));
         m_token = m_scanner.getNextToken();
     } else if (m_token == Token::T_LESS) {
         m_token = m_scanner.getNextToken();
-        while (m_token == Token::T_IDENTIFIER || m_token == Token::T_DOT)
+        while (m_token == Token::T_IDENTIFIER || m_token == Token::T_DOT ||
+               m_token == Token::T_SLASH)
+        {
+            if (m_token == Token::T_DOT)
+                name += '.';
+            else if (m_token == Token::T_SLASH)
+                name += '/';
+            else
+                name.append(m_token.getData(), m_token.getLength());
             m_token = m_scanner.getNextToken();
+        }
         if (m_token != Token::T_GREATER) {
             handleError();
             return false;
         }
+        m_includes.push_back(Include(name, false));
         m_token = m_scanner.getNextToken();
     } else {
         handleError();
@@ -159,6 +190,10 @@ bool Parser::parseDefinition()
         return false;
     }
 
+    m_interfaces.push_back(Interface(
+        m_names.intern(m_token.getData(), m_token.getLength()),
+        m_attributes, m_methods));
+
     m_token = m_scanner.getNextToken();
     if (m_token == Token::T_COLON) {
         m_token = m_scanner.getNextToken();
@@ -180,6 +215,8 @@ bool Parser::parseDefinition()
         return false;
     }
 
+    m_interfaces.back().finish();
+
     m_token = m_scanner.getNextToken();
     if (m_token != Token::T_SEMICOLON) {
         handleError();
@@ -198,6 +235,9 @@ bool Parser::parseBasicInterfaces()
             return false;
         }
 
+        m_interfaces.back().addBase(
+            m_names.intern(m_token.getData(), m_token.getLength()));
+
         m_token = m_scanner.getNextToken();
         if (m_token == Token::T_OPEN_BRACE)
             return true;
@@ -215,6 +255,26 @@ bool Parser::parseInterfaceBody()
 {
     while (1) {
         switch (m_token.getType()) {
+        case Token::T_OPEN_BRACKET: {
+            const std::string *message = NULL;
+            Attribute::ControllerEncoding encoding = Attribute::CONTROLLER_NONE;
+            if (!parseAnnotations(message, encoding))
+                return false;
+            if (!message)
+                continue;
+
+            // only attributes are sent in the controller handshake
+            if (m_token != Token::T_READONLY && m_token != Token::T_ATTRIBUTE) {
+                handleError();
+                return false;
+            }
+            const size_t first_attribute = m_attributes.size();
+            if (!parseAttribute())
+                return false;
+            for (size_t i = first_attribute; i < m_attributes.size(); ++i)
+                m_attributes[i].setController(*message, encoding);
+            break;
+        }
         case Token::T_READONLY:
         case Token::T_ATTRIBUTE:
             if (!parseAttribute())
@@ -253,6 +313,74 @@ bool Parser::parseInterfaceBody()
     return true;
 }
 
+// [name, name(arg, ...), ...] in front of an attribute or a method; only
+// controller(message, encoding) has a meaning for the generator
+bool Parser::parseAnnotations(const std::string *&controller_message,
+                              Attribute::ControllerEncoding &controller_encoding)
+{
+    if (m_token != Token::T_OPEN_BRACKET) {
+        handleError();
+        return false;
+    }
+
+    while (1) {
+        m_token = m_scanner.getNextToken();
+        if (m_token != Token::T_IDENTIFIER) {
+            handleError();
+            return false;
+        }
+
+        const bool controller = m_token.getParameter() == "controller";
+        std::vector<const std::string *> args;
+        m_token = m_scanner.getNextToken();
+        if (m_token == Token::T_OPEN_PARENTHESES) {
+            do {
+                m_token = m_scanner.getNextToken();
+                if (m_token != Token::T_IDENTIFIER) {
+                    handleError();
+                    return false;
+                }
+                args.push_back(&m_names.intern(m_token.getData(), m_token.getLength()));
+                m_token = m_scanner.getNextToken();
+            } while (m_token == Token::T_COMMA);
+
+            if (m_token != Token::T_CLOSE_PARENTHESES) {
+                handleError();
+                return false;
+            }
+            m_token = m_scanner.getNextToken();
+        }
+
+        if (controller) {
+            if (args.size() != 2) {
+                handleError();
+                return false;
+            }
+
+            const std::string &encoding = *args[1];
+            if (encoding == "str")
+                controller_encoding = Attribute::CONTROLLER_STR;
+            else if (encoding == "value")
+                controller_encoding = Attribute::CONTROLLER_VALUE;
+            else if (encoding == "bool")
+                controller_encoding = Attribute::CONTROLLER_BOOL;
+            else {
+                handleError();
+                return false;
+            }
+            controller_message = args[0];
+        }
+
+        if (m_token == Token::T_CLOSE_BRACKET) {
+            m_token = m_scanner.getNextToken();
+            return true;
+        } else if (m_token != Token::T_COMMA) {
+            handleError();
+            return false;
+        }
+    }
+}
+
 bool Parser::parseAttribute()
 {
     bool readonly = false;
@@ -278,7 +406,8 @@ bool Parser::parseAttribute()
         return false;
     }
 
-    m_attributes.push_back(Attribute(type.getType(), m_token.getParameter(), readonly));
+    m_attributes.push_back(Attribute(type.getType(),
+        m_names.intern(m_token.getData(), m_token.getLength()), readonly));
 
     m_token = m_scanner.getNextToken();
     if (m_token == Token::T_COMMA) {
@@ -289,7 +418,8 @@ bool Parser::parseAttribute()
                 return false;
             }
 
-            m_attributes.push_back(Attribute(type.getType(), m_token.getParameter(), readonly));
+            m_attributes.push_back(Attribute(type.getType(),
+                m_names.intern(m_token.getData(), m_token.getLength()), readonly));
             m_token = m_scanner.getNextToken();
             if (m_token == Token::T_SEMICOLON) {
                 break;
@@ -320,7 +450,7 @@ bool Parser::parseMethod()
         return false;
     }
 
-    std::string identifier = m_token.getParameter();
+    const std::string &identifier = m_names.intern(m_token.getData(), m_token.getLength());
 
     m_token = m_scanner.getNextToken();
     if (m_token != Token::T_OPEN_PARENTHESES) {
@@ -328,7 +458,7 @@ bool Parser::parseMethod()
         return false;
     }
 
-    std::list<Method::MethodParam> params;
+    const size_t first_param = m_params.size();
     m_token = m_scanner.getNextToken();
     if (m_token != Token::T_CLOSE_PARENTHESES) {
         while (1) {
@@ -349,8 +479,8 @@ bool Parser::parseMethod()
                 return false;
             }
 
-            params.push_back(Method::MethodParam(dir.getType(), type.getType(),
-                m_token.getParameter()));
+            m_params.push_back(Method::MethodParam(dir.getType(), type.getType(),
+                m_names.intern(m_token.getData(), m_token.getLength())));
 
             m_token = m_scanner.getNextToken();
             if (m_token == Token::T_COMMA) {
@@ -375,7 +505,8 @@ bool Parser::parseMethod()
         return false;
     }
 
-    m_methods.push_back(Method(type.getType(), identifier, params));
+    m_methods.push_back(Method(type.getType(), identifier, m_params,
+        first_param, m_params.size() - first_param));
 
     m_token = m_scanner.getNextToken();
     return true;
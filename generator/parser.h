@@ -18,8 +18,11 @@
 #ifndef PARSER_H
 #define PARSER_H
 
-#include <list>
+#include <string>
+#include <vector>
 #include "attribute.h"
+#include "interface.h"
+#include "interntable.h"
 #include "method.h"
 #include "scanner.h"
 #include "token.h"
@@ -27,21 +30,49 @@
 class Parser
 {
 public:
-    Parser();
+    struct Include
+    {
+        Include(const std::string &name, bool quoted):
+            name(name),
+            quoted(quoted)
+        {}
+
+        std::string name;
+        bool quoted;    // "name" rather than <name>
+    };
+
+public:
+    // filename, if not empty, prefixes the error messages
+    Parser(const ScannerInput &input, const std::string &filename = std::string());
     ~Parser();
 
     bool parse();
 
-    std::list<Attribute> getAttributes() const { return m_attributes; }
-    std::list<Method> getMethods() const { return m_methods; }
+    // valid for the lifetime of the parser
+    const std::vector<Attribute> &getAttributes() const { return m_attributes; }
+    const std::vector<Method> &getMethods() const { return m_methods; }
+    const std::vector<Interface> &getInterfaces() const { return m_interfaces; }
+    const std::vector<Include> &getIncludes() const { return m_includes; }
+
+    // figures of the parse so far, reported by --stats
+    size_t getTokenCount() const { return m_scanner.getTokenCount(); }
+    size_t getDeclarationCount() const
+    {
+        return m_interfaces.size() + m_attributes.size() + m_methods.size();
+    }
 
 private:
+    Parser(const Parser &copy);
+    Parser &operator=(const Parser &rhs);
+
     void handleError() const;
     bool parseInclude();
     bool parseDefinitionParams();
     bool parseDefinition();
     bool parseBasicInterfaces();
     bool parseInterfaceBody();
+    bool parseAnnotations(const std::string *&controller_message,
+                          Attribute::ControllerEncoding &controller_encoding);
     bool parseAttribute();
     bool parseType();
     bool parseMethod();
@@ -49,8 +80,13 @@ private:
 private:
     Scanner m_scanner;
     Token m_token;
-    std::list<Attribute> m_attributes;
-    std::list<Method> m_methods;
+    const std::string m_filename;
+    InternTable m_names;
+    std::vector<Attribute> m_attributes;
+    std::vector<Method> m_methods;
+    Method::ParamArena m_params;
+    std::vector<Interface> m_interfaces;
+    std::vector<Include> m_includes;
 };
 
 #endif // PARSER_H
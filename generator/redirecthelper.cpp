@@ -18,11 +18,8 @@
 #include "redirecthelper.h"
 
 RedirectHelper::RedirectHelper(const Options &o):
-    m_input_file(o.inputFilename()),
     m_output_file(o.outputFilename()),
-    m_ifb(),
     m_ofb(),
-    m_cin_streambuf(NULL),
     m_cout_streambuf(NULL)
 {
 }
@@ -34,18 +31,6 @@ RedirectHelper::~RedirectHelper()
 
 bool RedirectHelper::redirect()
 {
-    if (!m_cin_streambuf && !m_input_file.empty()) {
-        m_ifb.open(m_input_file.c_str(), std::ios::in);
-        if (!m_ifb.is_open()) {
-            std::cerr << "Unable to open '" << m_input_file << "' for reading!\n";
-            return false;
-        } else {
-            m_cin_streambuf = std::cin.rdbuf();
-            std::istream is(&m_ifb);
-            std::cin.rdbuf(is.rdbuf());
-        }
-    }
-
     if (!m_cout_streambuf && !m_output_file.empty()) {
         m_ofb.open(m_output_file.c_str(), std::ios::out);
         if (!m_ofb.is_open()) {
@@ -63,12 +48,6 @@ bool RedirectHelper::redirect()
 
 void RedirectHelper::restore()
 {
-    if (m_cin_streambuf) {
-        m_ifb.close();
-        std::cin.rdbuf(m_cin_streambuf);
-        m_cin_streambuf = NULL;
-    }
-
     if (m_cout_streambuf) {
         m_ofb.close();
         std::cout.rdbuf(m_cout_streambuf);
@@ -33,11 +33,8 @@ public:
     void restore();
 
 private:
-    std::string m_input_file;
     std::string m_output_file;
-    std::filebuf m_ifb;
     std::filebuf m_ofb;
-    std::streambuf *m_cin_streambuf;
     std::streambuf *m_cout_streambuf;
 };
 
@@ -15,53 +15,115 @@
 *   along with this program. If not, see <http://www.gnu.org/licenses/>.
 * ***** END LICENSE BLOCK ***** */
 
-#include <fstream>
 #include <cctype>
+#include <cstring>
 #include "scanner.h"
 
-std::map<std::string, Token::TokenType> Scanner::s_keywords;
+// Keywords are found by a perfect hash of the first and the last
+// character and the length of an identifier. The multipliers were chosen
+// so that no two keywords share a slot; a new keyword needs a free slot,
+// or new multipliers.
+#define KEYWORD_HASH_SIZE 64
 
-Scanner::Scanner():
+static inline unsigned int keywordHash(const char *str, size_t len)
+{
+    return (static_cast<unsigned char>(str[0]) * 3 +
+            static_cast<unsigned char>(str[len - 1]) * 42 + len) % KEYWORD_HASH_SIZE;
+}
+
+static const struct {
+    const char *name;
+    size_t length;
+    Token::TokenType type;
+} s_keywords[KEYWORD_HASH_SIZE] = {
+    { NULL, 0, Token::T_UNKNOWN },
+    { NULL, 0, Token::T_UNKNOWN },
+    { NULL, 0, Token::T_UNKNOWN },
+    { NULL, 0, Token::T_UNKNOWN },
+    { "double", 6, Token::T_DOUBLE },
+    { "string", 6, Token::T_STRING },
+    { NULL, 0, Token::T_UNKNOWN },
+    { NULL, 0, Token::T_UNKNOWN },
+    { "inout", 5, Token::T_INOUT },
+    { "in", 2, Token::T_IN },
+    { NULL, 0, Token::T_UNKNOWN },
+    { "uuid", 4, Token::T_UUID },
+    { NULL, 0, Token::T_UNKNOWN },
+    { NULL, 0, Token::T_UNKNOWN },
+    { "void", 4, Token::T_VOID },
+    { "unsigned", 8, Token::T_UNSIGNED },
+    { NULL, 0, Token::T_UNKNOWN },
+    { NULL, 0, Token::T_UNKNOWN },
+    { "wstring", 7, Token::T_WSTRING },
+    { NULL, 0, Token::T_UNKNOWN },
+    { "include", 7, Token::T_INCLUDE },
+    { NULL, 0, Token::T_UNKNOWN },
+    { "interface", 9, Token::T_INTERFACE },
+    { NULL, 0, Token::T_UNKNOWN },
+    { "out", 3, Token::T_OUT },
+    { NULL, 0, Token::T_UNKNOWN },
+    { "octet", 5, Token::T_OCTET },
+    { NULL, 0, Token::T_UNKNOWN },
+    { NULL, 0, Token::T_UNKNOWN },
+    { NULL, 0, Token::T_UNKNOWN },
+    { "wchar", 5, Token::T_WCHAR },
+    { "typedef", 7, Token::T_TYPEDEF },
+    { NULL, 0, Token::T_UNKNOWN },
+    { "char", 4, Token::T_CHAR },
+    { "native", 6, Token::T_NATIVE },
+    { NULL, 0, Token::T_UNKNOWN },
+    { NULL, 0, Token::T_UNKNOWN },
+    { NULL, 0, Token::T_UNKNOWN },
+    { "short", 5, Token::T_SHORT },
+    { NULL, 0, Token::T_UNKNOWN },
+    { NULL, 0, Token::T_UNKNOWN },
+    { NULL, 0, Token::T_UNKNOWN },
+    { NULL, 0, Token::T_UNKNOWN },
+    { NULL, 0, Token::T_UNKNOWN },
+    { NULL, 0, Token::T_UNKNOWN },
+    { NULL, 0, Token::T_UNKNOWN },
+    { "long", 4, Token::T_LONG },
+    { NULL, 0, Token::T_UNKNOWN },
+    { NULL, 0, Token::T_UNKNOWN },
+    { NULL, 0, Token::T_UNKNOWN },
+    { NULL, 0, Token::T_UNKNOWN },
+    { NULL, 0, Token::T_UNKNOWN },
+    { NULL, 0, Token::T_UNKNOWN },
+    { NULL, 0, Token::T_UNKNOWN },
+    { "const", 5, Token::T_CONST },
+    { NULL, 0, Token::T_UNKNOWN },
+    { "readonly", 8, Token::T_READONLY },
+    { "boolean", 7, Token::T_BOOLEAN },
+    { "raises", 6, Token::T_RAISES },
+    { NULL, 0, Token::T_UNKNOWN },
+    { NULL, 0, Token::T_UNKNOWN },
+    { NULL, 0, Token::T_UNKNOWN },
+    { "attribute", 9, Token::T_ATTRIBUTE },
+    { "float", 5, Token::T_FLOAT }
+};
+
+Scanner::Scanner(const ScannerInput &input):
+    m_pos(input.begin()),
+    m_end(input.end()),
     m_token(),
     m_line_no_start(1),
     m_line_no_end(m_line_no_start),
     m_accept_uuids(false),
+    m_token_count(0),
     m_token_queue()
 {
-    if (s_keywords.empty())
-        initKeywords();
 }
 
 Scanner::~Scanner()
 {
 }
 
-void Scanner::initKeywords()
+Token::TokenType Scanner::keywordType(const char *str, size_t len)
 {
-    s_keywords["attribute"] = Token::T_ATTRIBUTE;
-    s_keywords["const"] = Token::T_CONST;
-    s_keywords["in"] = Token::T_IN;
-    s_keywords["out"] = Token::T_OUT;
-    s_keywords["inout"] = Token::T_INOUT;
-    s_keywords["interface"] = Token::T_INTERFACE;
-    s_keywords["native"] = Token::T_NATIVE;
-    s_keywords["raises"] = Token::T_RAISES;
-    s_keywords["readonly"] = Token::T_READONLY;
-    s_keywords["typedef"] = Token::T_TYPEDEF;
-    s_keywords["uuid"] = Token::T_UUID;
-    s_keywords["float"] = Token::T_FLOAT;
-    s_keywords["double"] = Token::T_DOUBLE;
-    s_keywords["string"] = Token::T_STRING;
-    s_keywords["wstring"] = Token::T_WSTRING;
-    s_keywords["unsigned"] = Token::T_UNSIGNED;
-    s_keywords["short"] = Token::T_SHORT;
-    s_keywords["long"] = Token::T_LONG;
-    s_keywords["char"] = Token::T_CHAR;
-    s_keywords["wchar"] = Token::T_WCHAR;
-    s_keywords["boolean"] = Token::T_BOOLEAN;
-    s_keywords["void"] = Token::T_VOID;
-    s_keywords["octet"] = Token::T_OCTET;
-    s_keywords["include"] = Token::T_INCLUDE;
+    const unsigned int slot = keywordHash(str, len);
+    if (s_keywords[slot].length == len && memcmp(s_keywords[slot].name, str, len) == 0)
+        return s_keywords[slot].type;
+    return Token::T_IDENTIFIER;
 }
 
 Token Scanner::getNextToken()
@@ -72,22 +134,30 @@ Token Scanner::getNextToken()
         return t;
     }
 
+    Token t(scanToken());
+    if (t != Token::T_EOF && t != Token::T_LEX_ERROR)
+        ++m_token_count;
+    return t;
+}
+
+Token Scanner::scanToken()
+{
     enum { S_INITIAL, S_IDENTIFIER,
            S_NUMBER, S_COLON,
            S_SHIFT_LEFT, S_SHIFT_RIGHT,
            S_SLASH, S_BLOCK_COMMENT,
            S_UUID } state = S_INITIAL;
-    std::string param;
+    // start of the identifier, number or uuid being scanned
+    const char *param = NULL;
     int c = 0;
     int old_c;
 
     m_line_no_start = m_line_no_end;
     while (1) {
         old_c = c;
-        c = std::cin.get();
-
-        if (std::cin.eof())
+        if (eof())
             return Token(state == S_INITIAL ? Token::T_EOF : Token::T_LEX_ERROR);
+        c = get();
 
         if (c == '\n')
             ++m_line_no_end;
@@ -95,10 +165,10 @@ Token Scanner::getNextToken()
         switch (state) {
         case S_INITIAL:
             if (isalpha(c)) {
-                param += c;
+                param = m_pos - 1;
                 state = m_accept_uuids ? S_UUID : S_IDENTIFIER;
             } else if (isdigit(c)) {
-                param += c;
+                param = m_pos - 1;
                 state = m_accept_uuids ? S_UUID : S_NUMBER;
             }
             switch (c) {
@@ -162,64 +232,75 @@ Token Scanner::getNextToken()
 
         case S_IDENTIFIER:
             if (!isalnum(c) && c != '-' && c != '_') {
-                std::cin.unget();
-                std::map<std::string, Token::TokenType>::iterator it;
-                it = s_keywords.find(param);
-                if (it != s_keywords.end())
-                    return Token(it->second);
-                return Token(Token::T_IDENTIFIER, param);
+                unget();
+                const Token::TokenType type = keywordType(param, m_pos - param);
+                if (type != Token::T_IDENTIFIER)
+                    return Token(type);
+                return Token(Token::T_IDENTIFIER, param, m_pos - param);
             }
-            param += c;
             break;
 
         case S_NUMBER:
             if (!isdigit(c)) {
-                std::cin.unget();
-                return Token(Token::T_NUMBER, param);
+                unget();
+                return Token(Token::T_NUMBER, param, m_pos - param);
             }
-            param += c;
             break;
 
         case S_UUID: {
             if (!isdigit(c) && c != '-' && (c > 'f' || c < 'a')) {
-                std::cin.unget();
-                return Token(param.size() != 36 ? Token::T_LEX_ERROR : Token::T_UUIDVAL, param);
+                unget();
+                const int len = m_pos - param;
+                return Token(len != 36 ? Token::T_LEX_ERROR : Token::T_UUIDVAL, param, len);
             }
-            const int len = param.size();
+            const int len = m_pos - 1 - param;
             if (c != '-' && len >= 36 &&
                (len == 8 || len == 13 || len == 18 || len == 23))
             {
                 return Token(Token::T_LEX_ERROR);
             }
-            param += c;
             break;
         }
 
         case S_COLON:
             if (c == ':')
                 return Token(Token::T_DOUBLECOLON);
-            std::cin.unget();
+            unget();
             return Token(Token::T_COLON);
 
         case S_SHIFT_LEFT:
             if (c == '<')
                 return Token(Token::T_SHIFT_LEFT);
-            std::cin.unget();
+            unget();
             return Token(Token::T_LESS);
 
         case S_SHIFT_RIGHT:
             if (c == '>')
                 return Token(Token::T_SHIFT_RIGHT);
-            std::cin.unget();
+            unget();
             return Token(Token::T_GREATER);
 
         case S_SLASH:
             if (c == '/') {
-                while (c != '\n' && !std::cin.eof())
-                    c = std::cin.get();
+                // "//@" hides generator annotations from xpidl, the rest of
+                // the line is scanned as usual
+                if (!eof() && *m_pos == '@') {
+                    get();
+                    state = S_INITIAL;
+                    break;
+                }
+                while (c != '\n' && !eof())
+                    c = get();
                 state = S_INITIAL;
             } else if (c == '*') {
+                // the opening star must not close the comment, as in "/*/"
+                c = 0;
                 state = S_BLOCK_COMMENT;
+            } else {
+                unget();
+                if (c == '\n')
+                    --m_line_no_end;
+                return Token(Token::T_SLASH);
             }
             break;
 
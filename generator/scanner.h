@@ -18,33 +18,41 @@
 #ifndef SCANNER_H
 #define SCANNER_H
 
-#include <iostream>
-#include <string>
-#include <map>
 #include <queue>
+#include "scannerinput.h"
 #include "token.h"
 
 class Scanner
 {
 public:
-    Scanner();
+    Scanner(const ScannerInput &input);
     ~Scanner();
 
     Token getNextToken();
     int getLineNo() const { return m_line_no_start; }
+    // tokens lexed from the input so far, pushed back ones count once
+    size_t getTokenCount() const { return m_token_count; }
     void pushToken(Token &token) { m_token_queue.push(token); }
     void setAcceptUuids(bool accept = true) { m_accept_uuids = accept; }
 
 private:
-    static void initKeywords();
+    Token scanToken();
+    static Token::TokenType keywordType(const char *str, size_t len);
+
+    // the input is lexed in place, get() returns -1 at its end
+    bool eof() const { return m_pos == m_end; }
+    int get() { return eof() ? -1 : static_cast<unsigned char>(*m_pos++); }
+    void unget() { --m_pos; }
 
 private:
+    const char *m_pos;
+    const char *m_end;
     Token m_token;
     int m_line_no_start;
     int m_line_no_end;
     bool m_accept_uuids;
+    size_t m_token_count;
     std::queue<Token> m_token_queue;
-    static std::map<std::string, Token::TokenType> s_keywords;
 };
 
 #endif // SCANNER_H
@@ -0,0 +1,124 @@
+/* ***** BEGIN LICENSE BLOCK *****
+*   Copyright (C) 2026, Red Hat Inc.
+*
+*   This program is free software; you can redistribute it and/or
+*   modify it under the terms of the GNU General Public License as
+*   published by the Free Software Foundation; either version 2 of
+*   the License, or (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program. If not, see <http://www.gnu.org/licenses/>.
+* ***** END LICENSE BLOCK ***** */
+
+#include <iostream>
+#include <sstream>
+#include <cerrno>
+#include <cstring>
+extern "C" {
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+}
+#include "scannerinput.h"
+
+ScannerInput::ScannerInput():
+    m_data(NULL),
+    m_size(0),
+    m_map(NULL),
+    m_buffer()
+{
+}
+
+ScannerInput::~ScannerInput()
+{
+    close();
+}
+
+bool ScannerInput::open(const std::string &filename)
+{
+    close();
+
+    // included files are opened by several threads, each message is
+    // written at once
+    std::ostringstream msg;
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        msg << "Unable to open '" << filename << "' for reading!\n";
+        std::cerr << msg.str();
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+        void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map != MAP_FAILED) {
+            ::close(fd);
+            m_map = map;
+            m_data = static_cast<const char *>(map);
+            m_size = st.st_size;
+            return true;
+        }
+    }
+
+    // not mappable, e.g. a fifo
+    bool ok = readFd(fd);
+    ::close(fd);
+    if (!ok) {
+        msg << "Unable to read '" << filename << "'!\n";
+        std::cerr << msg.str();
+    }
+    return ok;
+}
+
+bool ScannerInput::readStdin()
+{
+    close();
+
+    if (!readFd(STDIN_FILENO)) {
+        std::cerr << "Unable to read the standard input!\n";
+        return false;
+    }
+    return true;
+}
+
+void ScannerInput::assign(const char *data, size_t size)
+{
+    close();
+    m_data = data;
+    m_size = size;
+}
+
+bool ScannerInput::readFd(int fd)
+{
+    char chunk[65536];
+    ssize_t len;
+
+    while ((len = read(fd, chunk, sizeof(chunk))) != 0) {
+        if (len < 0) {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+        m_buffer.append(chunk, len);
+    }
+
+    m_data = m_buffer.data();
+    m_size = m_buffer.size();
+    return true;
+}
+
+void ScannerInput::close()
+{
+    if (m_map)
+        munmap(m_map, m_size);
+    m_map = NULL;
+    m_buffer.clear();
+    m_data = NULL;
+    m_size = 0;
+}
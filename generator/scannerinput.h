@@ -0,0 +1,53 @@
+/* ***** BEGIN LICENSE BLOCK *****
+*   Copyright (C) 2026, Red Hat Inc.
+*
+*   This program is free software; you can redistribute it and/or
+*   modify it under the terms of the GNU General Public License as
+*   published by the Free Software Foundation; either version 2 of
+*   the License, or (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program. If not, see <http://www.gnu.org/licenses/>.
+* ***** END LICENSE BLOCK ***** */
+
+#ifndef SCANNERINPUT_H
+#define SCANNERINPUT_H
+
+#include <string>
+
+// Whole input of the scanner in one contiguous block: a regular file is
+// memory-mapped, anything else (stdin, pipes) is read into a buffer.
+class ScannerInput
+{
+public:
+    ScannerInput();
+    ~ScannerInput();
+
+    bool open(const std::string &filename);
+    bool readStdin();
+    // borrows the data, which has to outlive the input (used by the fuzzer)
+    void assign(const char *data, size_t size);
+
+    const char *begin() const { return m_data; }
+    const char *end() const { return m_data + m_size; }
+
+private:
+    ScannerInput(const ScannerInput &copy);
+    ScannerInput &operator=(const ScannerInput &rhs);
+
+    bool readFd(int fd);
+    void close();
+
+private:
+    const char *m_data;
+    size_t m_size;
+    void *m_map;
+    std::string m_buffer;
+};
+
+#endif // SCANNERINPUT_H
@@ -0,0 +1,302 @@
+/* ***** BEGIN LICENSE BLOCK *****
+*   Copyright (C) 2026, Red Hat Inc.
+*
+*   This program is free software; you can redistribute it and/or
+*   modify it under the terms of the GNU General Public License as
+*   published by the Free Software Foundation; either version 2 of
+*   the License, or (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program. If not, see <http://www.gnu.org/licenses/>.
+* ***** END LICENSE BLOCK ***** */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include "generator.h"
+#include "schemagenerator.h"
+
+SchemaGenerator::SchemaGenerator(const std::vector<Attribute> &attributes, Format format):
+    m_attributes(attributes),
+    m_format(format),
+    m_output()
+{
+}
+
+SchemaGenerator::~SchemaGenerator()
+{
+}
+
+bool SchemaGenerator::generate()
+{
+    if (m_format == FORMAT_CPP)
+        generateCpp();
+    else
+        generateJson();
+    return m_output.writeTo(std::cout);
+}
+
+// one attribute per line, in the order of the IDL
+void SchemaGenerator::generateJson()
+{
+    m_output << "{\"attributes\":[";
+    std::vector<Attribute>::const_iterator it;
+    for (it = m_attributes.begin(); it != m_attributes.end(); ++it) {
+        m_output << (it == m_attributes.begin() ? "\n" : ",\n")
+                 << "{\"name\":" << jsonString(it->getIdentifier())
+                 << ",\"type\":\"" << typeName(it->getType())
+                 << "\",\"readonly\":" << (it->isReadonly() ? "true" : "false");
+
+        std::string value;
+        if (Generator::defaultAttributeValue(*it, value))
+            m_output << ",\"test_page_preset\":" << jsonPreset(*it, value);
+        m_output << "}";
+    }
+    m_output << "\n]}\n";
+}
+
+void SchemaGenerator::generateCpp()
+{
+    m_output << "/* Generated by spice-xpi-generator from nsISpicec.idl, do not edit:\n"
+             << " *   spice-xpi-generator -m schema-cpp -i nsISpicec.idl -o property-schema.h\n"
+             << " */\n\n"
+             << "#ifndef SPICE_PROPERTY_SCHEMA_H\n"
+             << "#define SPICE_PROPERTY_SCHEMA_H\n\n"
+             << "#include <cctype>\n"
+             << "#include <cerrno>\n"
+             << "#include <cstdlib>\n"
+             << "#include <cstring>\n\n"
+             << "class PropertySchema\n{\n"
+             << "public:\n"
+             << "    enum Type {\n"
+             << "        TYPE_STRING,\n"
+             << "        TYPE_BOOLEAN,\n"
+             << "        TYPE_SIGNED,\n"
+             << "        TYPE_UNSIGNED,\n"
+             << "        TYPE_FLOAT\n"
+             << "    };\n\n"
+             << "    struct Property {\n"
+             << "        const char *name;\n"
+             << "        const char *idl_type;\n"
+             << "        Type type;\n"
+             << "        double min;             // range of the numeric types\n"
+             << "        double max;\n"
+             << "        bool readonly;\n"
+             << "        // value preset on the test page, not the plugin's default;\n"
+             << "        // NULL, if there is none\n"
+             << "        const char *test_page_preset;\n"
+             << "    };\n\n";
+
+    generateCppTable();
+
+    m_output << "    // NULL for an unknown name\n"
+             << "    static const Property *Find(const char *name)\n    {\n"
+             << "        const Property *properties = Properties();\n"
+             << "        size_t lo = 0;\n"
+             << "        size_t hi = PROPERTY_COUNT;\n"
+             << "        while (lo < hi) {\n"
+             << "            const size_t mid = (lo + hi) / 2;\n"
+             << "            const int cmp = strcmp(name, properties[mid].name);\n"
+             << "            if (cmp == 0)\n"
+             << "                return &properties[mid];\n"
+             << "            if (cmp < 0)\n"
+             << "                hi = mid;\n"
+             << "            else\n"
+             << "                lo = mid + 1;\n"
+             << "        }\n"
+             << "        return NULL;\n"
+             << "    }\n\n"
+             << "    // checks a value written to the property as a string, as a config\n"
+             << "    // pushes it; an empty value, which resets the property, is valid\n"
+             << "    // only for a string. Numbers are plain decimals: no leading\n"
+             << "    // whitespace, no hexadecimal and no exponent for the integers.\n"
+             << "    static bool Validate(const Property &property, const char *value)\n    {\n"
+             << "        if (property.readonly)\n"
+             << "            return false;\n"
+             << "        if (property.type == TYPE_STRING)\n"
+             << "            return true;\n"
+             << "        if (property.type == TYPE_BOOLEAN)\n"
+             << "            return !strcmp(value, \"true\") || !strcmp(value, \"false\") ||\n"
+             << "                   !strcmp(value, \"1\") || !strcmp(value, \"0\");\n\n"
+             << "        const unsigned char first = *value;\n"
+             << "        char *end;\n"
+             << "        errno = 0;\n"
+             << "        if (property.type == TYPE_FLOAT) {\n"
+             << "            if (!isdigit(first) && first != '-' && first != '+' && first != '.')\n"
+             << "                return false;\n"
+             << "            strtod(value, &end);\n"
+             << "            return *end == '\\0' && errno != ERANGE;\n"
+             << "        }\n\n"
+             << "        if (property.type == TYPE_SIGNED) {\n"
+             << "            if (!isdigit(first) && first != '-')\n"
+             << "                return false;\n"
+             << "            const long long number = strtoll(value, &end, 10);\n"
+             << "            return *end == '\\0' && errno != ERANGE &&\n"
+             << "                   number >= property.min && number <= property.max;\n"
+             << "        }\n\n"
+             << "        // strtoull() would wrap a negative value around\n"
+             << "        if (!isdigit(first))\n"
+             << "            return false;\n"
+             << "        const unsigned long long number = strtoull(value, &end, 10);\n"
+             << "        return *end == '\\0' && errno != ERANGE && number <= property.max;\n"
+             << "    }\n"
+             << "};\n\n"
+             << "#endif // SPICE_PROPERTY_SCHEMA_H\n";
+}
+
+// sorted by name, so that Find() can bisect it
+void SchemaGenerator::generateCppTable()
+{
+    std::vector<const Attribute *> sorted;
+    std::vector<Attribute>::const_iterator it;
+    for (it = m_attributes.begin(); it != m_attributes.end(); ++it)
+        sorted.push_back(&*it);
+    std::sort(sorted.begin(), sorted.end(), compareIdentifiers);
+
+    char count[32];
+    snprintf(count, sizeof(count), "%u", static_cast<unsigned int>(sorted.size()));
+    m_output << "    enum {\n"
+             << "        PROPERTY_COUNT = " << count << "\n"
+             << "    };\n\n"
+             << "    static const Property *Properties()\n    {\n"
+             << "        static const Property properties[PROPERTY_COUNT] = {\n";
+
+    std::vector<const Attribute *>::const_iterator its;
+    for (its = sorted.begin(); its != sorted.end(); ++its) {
+        const Attribute &attr = **its;
+        std::string value;
+        const bool has_preset = Generator::defaultAttributeValue(attr, value);
+        m_output << "            { \"" << attr.getIdentifier() << "\", \""
+                 << typeName(attr.getType()) << "\", "
+                 << cppType(attr.getType()) << ", "
+                 << cppRange(attr.getType()) << ", "
+                 << (attr.isReadonly() ? "true" : "false") << ", "
+                 << (has_preset ? jsonString(value) : std::string("NULL")) << " }"
+                 << (its + 1 != sorted.end() ? ",\n" : "\n");
+    }
+
+    m_output << "        };\n"
+             << "        return properties;\n"
+             << "    }\n\n";
+}
+
+const char *SchemaGenerator::typeName(Token::TokenType type)
+{
+    switch (type) {
+    case Token::T_FLOAT:
+        return "float";
+    case Token::T_DOUBLE:
+        return "double";
+    case Token::T_STRING:
+        return "string";
+    case Token::T_WSTRING:
+        return "wstring";
+    case Token::T_SHORT:
+        return "short";
+    case Token::T_LONG:
+        return "long";
+    case Token::T_LONG_LONG:
+        return "long long";
+    case Token::T_UNSIGNED_SHORT:
+        return "unsigned short";
+    case Token::T_UNSIGNED_LONG:
+        return "unsigned long";
+    case Token::T_UNSIGNED_LONG_LONG:
+        return "unsigned long long";
+    case Token::T_CHAR:
+        return "char";
+    case Token::T_WCHAR:
+        return "wchar";
+    case Token::T_BOOLEAN:
+        return "boolean";
+    case Token::T_OCTET:
+        return "octet";
+    default:
+        return "unknown";
+    }
+}
+
+const char *SchemaGenerator::cppType(Token::TokenType type)
+{
+    switch (type) {
+    case Token::T_BOOLEAN:
+        return "TYPE_BOOLEAN";
+    case Token::T_FLOAT:
+    case Token::T_DOUBLE:
+        return "TYPE_FLOAT";
+    case Token::T_SHORT:
+    case Token::T_LONG:
+    case Token::T_LONG_LONG:
+        return "TYPE_SIGNED";
+    case Token::T_UNSIGNED_SHORT:
+    case Token::T_UNSIGNED_LONG:
+    case Token::T_UNSIGNED_LONG_LONG:
+    case Token::T_OCTET:
+        return "TYPE_UNSIGNED";
+    default:
+        return "TYPE_STRING";
+    }
+}
+
+// the 64-bit bounds are rounded to the nearest double
+const char *SchemaGenerator::cppRange(Token::TokenType type)
+{
+    switch (type) {
+    case Token::T_SHORT:
+        return "-32768.0, 32767.0";
+    case Token::T_LONG:
+        return "-2147483648.0, 2147483647.0";
+    case Token::T_LONG_LONG:
+        return "-9223372036854775808.0, 9223372036854775807.0";
+    case Token::T_UNSIGNED_SHORT:
+        return "0.0, 65535.0";
+    case Token::T_UNSIGNED_LONG:
+        return "0.0, 4294967295.0";
+    case Token::T_UNSIGNED_LONG_LONG:
+        return "0.0, 18446744073709551615.0";
+    case Token::T_OCTET:
+        return "0.0, 255.0";
+    default:
+        return "0.0, 0.0";
+    }
+}
+
+// also a valid C++ literal, as long as there are no control characters
+std::string SchemaGenerator::jsonString(const std::string &str)
+{
+    std::string result("\"");
+    for (std::string::const_iterator it = str.begin(); it != str.end(); ++it) {
+        const unsigned char c = *it;
+        if (c == '"' || c == '\\') {
+            result += '\\';
+            result += c;
+        } else if (c < 0x20) {
+            char buf[8];
+            snprintf(buf, sizeof(buf), "\\u%04x", c);
+            result += buf;
+        } else {
+            result += c;
+        }
+    }
+    result += '"';
+    return result;
+}
+
+std::string SchemaGenerator::jsonPreset(const Attribute &attr, const std::string &value)
+{
+    if (attr.getType() == Token::T_BOOLEAN)
+        return value == "true" ? "true" : "false";
+    if (strcmp(cppType(attr.getType()), "TYPE_STRING") != 0)
+        return value;
+    return jsonString(value);
+}
+
+bool SchemaGenerator::compareIdentifiers(const Attribute *a, const Attribute *b)
+{
+    return a->getIdentifier() < b->getIdentifier();
+}
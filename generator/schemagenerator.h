@@ -0,0 +1,64 @@
+/* ***** BEGIN LICENSE BLOCK *****
+*   Copyright (C) 2026, Red Hat Inc.
+*
+*   This program is free software; you can redistribute it and/or
+*   modify it under the terms of the GNU General Public License as
+*   published by the Free Software Foundation; either version 2 of
+*   the License, or (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program. If not, see <http://www.gnu.org/licenses/>.
+* ***** END LICENSE BLOCK ***** */
+
+#ifndef SCHEMAGENERATOR_H
+#define SCHEMAGENERATOR_H
+
+#include <string>
+#include <vector>
+#include "attribute.h"
+#include "outputbuffer.h"
+
+// Emits the schema of the plugin's properties: name, IDL type, readonly
+// flag and the value preset on the test page (which is not necessarily
+// the plugin's default) of every attribute, either as compact JSON for
+// the front ends, or as a C++ header with a sorted table and a
+// validator of values given as strings.
+class SchemaGenerator
+{
+public:
+    enum Format {
+        FORMAT_JSON,
+        FORMAT_CPP
+    };
+
+public:
+    SchemaGenerator(const std::vector<Attribute> &attributes, Format format);
+    ~SchemaGenerator();
+
+    // writes the schema to std::cout at once
+    bool generate();
+
+private:
+    void generateJson();
+    void generateCpp();
+    void generateCppTable();
+
+    static const char *typeName(Token::TokenType type);
+    static const char *cppType(Token::TokenType type);
+    static const char *cppRange(Token::TokenType type);
+    static std::string jsonString(const std::string &str);
+    static std::string jsonPreset(const Attribute &attr, const std::string &value);
+    static bool compareIdentifiers(const Attribute *a, const Attribute *b);
+
+private:
+    const std::vector<Attribute> &m_attributes;
+    const Format m_format;
+    OutputBuffer m_output;
+};
+
+#endif // SCHEMAGENERATOR_H
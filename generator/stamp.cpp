@@ -0,0 +1,143 @@
+/* ***** BEGIN LICENSE BLOCK *****
+*   Copyright (C) 2026, Red Hat Inc.
+*
+*   This program is free software; you can redistribute it and/or
+*   modify it under the terms of the GNU General Public License as
+*   published by the Free Software Foundation; either version 2 of
+*   the License, or (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program. If not, see <http://www.gnu.org/licenses/>.
+* ***** END LICENSE BLOCK ***** */
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+extern "C" {
+#  include <unistd.h>
+#  include <utime.h>
+}
+#include "stamp.h"
+
+// the generator's own binary, its hash stands for the version of the
+// generated output
+#define STAMP_GENERATOR_PATH "/proc/self/exe"
+
+Stamp::Stamp(const Options &o):
+    m_filename(),
+    m_output_filename(o.outputFilename()),
+    m_header(),
+    m_files()
+{
+    if (o.inputFilename().empty() || m_output_filename.empty())
+        return;
+
+    // without the binary, a changed generator can't be told from the one
+    // which made the output, which is then always regenerated
+    ScannerInput generator;
+    if (access(STAMP_GENERATOR_PATH, R_OK) != 0 || !generator.open(STAMP_GENERATOR_PATH))
+        return;
+
+    m_filename = m_output_filename + ".stamp";
+    m_header.push_back("generator " + hash(generator));
+    m_header.push_back("mode " + o.modeName());
+
+    const std::vector<std::string> &include_paths = o.includePaths();
+    std::vector<std::string>::const_iterator it;
+    for (it = include_paths.begin(); it != include_paths.end(); ++it)
+        m_header.push_back("include " + *it);
+}
+
+Stamp::~Stamp()
+{
+}
+
+std::string Stamp::hash(const ScannerInput &input)
+{
+    // 64-bit FNV-1a; detects edits, not meant to resist forgery
+    unsigned long long h = 14695981039346656037ULL;
+    for (const char *p = input.begin(); p != input.end(); ++p) {
+        h ^= static_cast<unsigned char>(*p);
+        h *= 1099511628211ULL;
+    }
+
+    char buf[17];
+    snprintf(buf, sizeof(buf), "%016llx", h);
+    return buf;
+}
+
+bool Stamp::upToDate() const
+{
+    if (!enabled() || access(m_output_filename.c_str(), F_OK) != 0)
+        return false;
+
+    std::ifstream in(m_filename.c_str());
+    if (!in)
+        return false;
+
+    std::string line;
+    std::vector<std::string>::const_iterator it;
+    for (it = m_header.begin(); it != m_header.end(); ++it) {
+        if (!std::getline(in, line) || line != *it)
+            return false;
+    }
+
+    // files: "<hash> <path>", the main input is the first one
+    bool any_file = false;
+    while (std::getline(in, line)) {
+        if (line.size() < 18 || line[16] != ' ')
+            return false;
+
+        ScannerInput input;
+        if (access(line.c_str() + 17, R_OK) != 0 || !input.open(line.substr(17)))
+            return false;
+        if (line.compare(0, 16, hash(input)) != 0)
+            return false;
+        any_file = true;
+    }
+    return any_file;
+}
+
+void Stamp::addFile(const std::string &path, const ScannerInput &input)
+{
+    if (enabled())
+        m_files.push_back(hash(input) + " " + path);
+}
+
+bool Stamp::save() const
+{
+    if (!enabled())
+        return true;
+
+    std::ofstream out(m_filename.c_str());
+    std::vector<std::string>::const_iterator it;
+    for (it = m_header.begin(); it != m_header.end(); ++it)
+        out << *it << "\n";
+    for (it = m_files.begin(); it != m_files.end(); ++it)
+        out << *it << "\n";
+    out.close();
+
+    if (!out) {
+        std::cerr << "Unable to write '" << m_filename << "'!\n";
+        remove();
+        return false;
+    }
+    return true;
+}
+
+void Stamp::touch() const
+{
+    if (enabled() && utime(m_filename.c_str(), NULL) != 0)
+        std::cerr << "Unable to touch '" << m_filename << "'!\n";
+}
+
+void Stamp::remove() const
+{
+    if (enabled())
+        unlink(m_filename.c_str());
+}
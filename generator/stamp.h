@@ -0,0 +1,56 @@
+/* ***** BEGIN LICENSE BLOCK *****
+*   Copyright (C) 2026, Red Hat Inc.
+*
+*   This program is free software; you can redistribute it and/or
+*   modify it under the terms of the GNU General Public License as
+*   published by the Free Software Foundation; either version 2 of
+*   the License, or (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program. If not, see <http://www.gnu.org/licenses/>.
+* ***** END LICENSE BLOCK ***** */
+
+#ifndef STAMP_H
+#define STAMP_H
+
+#include <string>
+#include <vector>
+#include "options.h"
+#include "scannerinput.h"
+
+// Records, next to the output file, what the output was generated from:
+// a hash of the generator binary, the output mode, the include paths and
+// a hash of every IDL file which was read. If nothing of it changed, the output file is left
+// alone, so its mtime does not trigger any rebuild; the stamp is touched
+// instead, for the make rules which target it, see data/Makefile.am.
+class Stamp
+{
+public:
+    Stamp(const Options &o);
+    ~Stamp();
+
+    // stamping needs named input and output files
+    bool enabled() const { return !m_filename.empty(); }
+    bool upToDate() const;
+
+    void addFile(const std::string &path, const ScannerInput &input);
+    bool save() const;
+    void touch() const;
+    void remove() const;
+
+private:
+    static std::string hash(const ScannerInput &input);
+
+private:
+    std::string m_filename;
+    std::string m_output_filename;
+    std::vector<std::string> m_header;
+    std::vector<std::string> m_files;
+};
+
+#endif // STAMP_H
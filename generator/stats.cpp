@@ -0,0 +1,64 @@
+/* ***** BEGIN LICENSE BLOCK *****
+*   Copyright (C) 2026, Red Hat Inc.
+*
+*   This program is free software; you can redistribute it and/or
+*   modify it under the terms of the GNU General Public License as
+*   published by the Free Software Foundation; either version 2 of
+*   the License, or (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program. If not, see <http://www.gnu.org/licenses/>.
+* ***** END LICENSE BLOCK ***** */
+
+#include <cstdio>
+extern "C" {
+#  include <time.h>
+}
+#include "stats.h"
+
+Stats::Stats():
+    m_parse_start(0.0),
+    m_parse_time(0.0),
+    m_files(0),
+    m_bytes(0),
+    m_tokens(0),
+    m_declarations(0)
+{
+}
+
+Stats::~Stats()
+{
+}
+
+double Stats::now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+void Stats::addFile(const ScannerInput &input, const Parser &parser)
+{
+    ++m_files;
+    m_bytes += input.end() - input.begin();
+    m_tokens += parser.getTokenCount();
+    m_declarations += parser.getDeclarationCount();
+}
+
+void Stats::print() const
+{
+    fprintf(stderr, "input:   %lu files, %lu bytes\n",
+        static_cast<unsigned long>(m_files),
+        static_cast<unsigned long>(m_bytes));
+    fprintf(stderr, "scanner: %lu tokens in %.3f ms, %.2f Mtokens/s\n",
+        static_cast<unsigned long>(m_tokens), m_parse_time * 1e3,
+        m_parse_time > 0.0 ? m_tokens / m_parse_time / 1e6 : 0.0);
+    fprintf(stderr, "parser:  %lu declarations in %.3f ms, %.2f Mdeclarations/s\n",
+        static_cast<unsigned long>(m_declarations), m_parse_time * 1e3,
+        m_parse_time > 0.0 ? m_declarations / m_parse_time / 1e6 : 0.0);
+}
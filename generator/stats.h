@@ -0,0 +1,54 @@
+/* ***** BEGIN LICENSE BLOCK *****
+*   Copyright (C) 2026, Red Hat Inc.
+*
+*   This program is free software; you can redistribute it and/or
+*   modify it under the terms of the GNU General Public License as
+*   published by the Free Software Foundation; either version 2 of
+*   the License, or (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program. If not, see <http://www.gnu.org/licenses/>.
+* ***** END LICENSE BLOCK ***** */
+
+#ifndef STATS_H
+#define STATS_H
+
+#include "parser.h"
+#include "scannerinput.h"
+
+// Throughput of the scanner and the parser, reported with --stats to
+// track the performance of the front end on large inputs. The scanner
+// runs interleaved with the parser, so the tokens and the declarations
+// of the main IDL and of the included files share one parse time.
+class Stats
+{
+public:
+    Stats();
+    ~Stats();
+
+    void startParse() { m_parse_start = now(); }
+    void stopParse() { m_parse_time = now() - m_parse_start; }
+
+    void addFile(const ScannerInput &input, const Parser &parser);
+
+    // prints the figures to stderr
+    void print() const;
+
+private:
+    static double now();
+
+private:
+    double m_parse_start;
+    double m_parse_time;
+    size_t m_files;
+    size_t m_bytes;
+    size_t m_tokens;
+    size_t m_declarations;
+};
+
+#endif // STATS_H
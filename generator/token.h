@@ -38,32 +38,26 @@ public:
     } TokenType;
 
 public:
+    // The parameter is a span of the scanner's input, which outlives the
+    // tokens, so tokens are copied without any allocation.
     Token():
         m_type(T_UNKNOWN),
-        m_param()
+        m_param(NULL),
+        m_length(0)
     {}
 
-    Token(TokenType type, const std::string &parameter = std::string()):
+    Token(TokenType type, const char *parameter = NULL, size_t length = 0):
         m_type(type),
-        m_param(parameter)
-    {}
-
-    Token(const Token &copy):
-        m_type(copy.m_type),
-        m_param(copy.m_param)
-    {}
-
-    ~Token()
+        m_param(parameter),
+        m_length(length)
     {}
 
     TokenType getType() const { return m_type; }
-    std::string getParameter() const { return m_param; }
-
-    Token &operator= (const Token& rhs)
+    const char *getData() const { return m_param; }
+    size_t getLength() const { return m_length; }
+    std::string getParameter() const
     {
-        m_type = rhs.m_type;
-        m_param = rhs.m_param;
-        return *this;
+        return m_length ? std::string(m_param, m_length) : std::string();
     }
 
     bool operator==(Token::TokenType type) const { return m_type == type; }
@@ -71,7 +65,8 @@ public:
 
 private:
     TokenType m_type;
-    std::string m_param;
+    const char *m_param;
+    size_t m_length;
 };
 
 #endif // TOKEN_H